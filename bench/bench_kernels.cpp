@@ -0,0 +1,106 @@
+#include "../include/ResourceManager.h"
+#include "../include/VectorKernels.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Scalar vs SIMD row kernels as the resource count grows: for each size,
+// one row per kernel set the CPU supports, timing rowFits/rowAccumulate on
+// their own and the Banker's safety check (SWEEP and INDEXED) on a random
+// safe state. 'speedup' is SWEEP relative to the scalar kernels.
+//
+// Build:  g++ -std=c++17 -O2 -pthread -Iinclude -o bench_kernels bench/bench_kernels.cpp src/*.cpp
+// Usage:  ./bench_kernels [processes] [repeats] [resource counts...]
+//         (default: 256 processes, 20 repeats, 16 64 256 1024 resources)
+
+const int TRIALS = 5;
+
+// Microseconds per call of 'body', averaged over 'repeats' calls; the best
+// of TRIALS runs, to keep scheduler noise out of small sizes.
+template <typename Body>
+double timeUs(int repeats, Body body)
+{
+    double best = 0;
+    for (int trial = 0; trial < TRIALS; ++trial)
+    {
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < repeats; ++i)
+            body();
+        chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+        if (trial == 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+    return best / repeats;
+}
+
+// Time every supported kernel set on n processes x m resources.
+void run(int n, int m, int repeats)
+{
+    // Random state: every process claims and holds a little of everything,
+    // and the claims are sized so the state is safe (a full sweep).
+    mt19937 rng(42);
+    ResourceManager rm;
+    rm.events.level = LogLevel::OFF;
+    for (int r = 1; r <= m; ++r)
+        rm.addResource(Resource(r, 4 * n));
+    for (int p = 1; p <= n; ++p)
+    {
+        rm.addProcess(Process(p));
+        for (int r = 1; r <= m; ++r)
+        {
+            rm.declareMaxResources(p, r, 2 + rng() % 4);
+            rm.requestResource(p, r, 1 + rng() % 2);
+        }
+    }
+
+    // Standalone rows, same width as the matrices.
+    vector<int> need(m, 1), work(m, 2), allocation(m, 1);
+
+    double scalarSweep = 0;
+    for (KernelSet kernels : {KernelSet::SCALAR, KernelSet::SSE41, KernelSet::AVX2})
+    {
+        if (!selectKernelSet(kernels))
+            continue;
+        volatile bool sink = false;
+        double fits = timeUs(repeats * 1000, [&]
+                             { sink = rowFits(need.data(), work.data(), m); });
+        double accumulate = timeUs(repeats * 1000, [&]
+                                   { rowAccumulate(work.data(), allocation.data(), m); });
+        rm.detector.safetyEngine = SafetyEngine::SWEEP;
+        double sweep = timeUs(repeats, [&]
+                              { sink = rm.detector.isSafeState(rm); });
+        rm.detector.safetyEngine = SafetyEngine::INDEXED;
+        double indexed = timeUs(repeats, [&]
+                                { sink = rm.detector.isSafeState(rm); });
+        if (kernels == KernelSet::SCALAR)
+            scalarSweep = sweep;
+        cout << setw(9) << m << "  " << left << setw(7) << kernelSetName(activeKernelSet()) << right << fixed
+             << setprecision(1) << setw(12) << fits * 1000 << setw(14) << accumulate * 1000 << setw(11) << sweep
+             << setw(13) << indexed << setw(8) << setprecision(2) << scalarSweep / sweep << "x"
+             << (sink ? "" : "  (unsafe)") << "\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? stoi(argv[1]) : 256;
+    int repeats = argc > 2 ? stoi(argv[2]) : 20;
+    vector<int> sizes;
+    for (int i = 3; i < argc; ++i)
+        sizes.push_back(stoi(argv[i]));
+    if (sizes.empty())
+        sizes = {16, 64, 256, 1024};
+
+    KernelSet original = activeKernelSet();
+    cout << "processes=" << n << " best=" << kernelSetName(bestKernelSet()) << "\n";
+    cout << "resources  kernels  rowFits ns  rowAccum ns  SWEEP us  INDEXED us  speedup\n";
+    for (int m : sizes)
+        run(n, m, repeats);
+    selectKernelSet(original);
+    return 0;
+}
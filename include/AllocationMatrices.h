@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+using namespace std;
+
+// Banker's and reduction matrices stored contiguously, row-major.
+// Row = process slot, column = resource slot.
+class AllocationMatrices
+{
+public:
+    int rows = 0;
+    int cols = 0;
+
+    vector<int> allocation;
+    vector<int> maxClaim;
+    vector<int> need; // maxClaim - allocation
+    vector<int> request; // Outstanding (queued) requests.
+
+    // Grow by one process (row) or one resource (column).
+    void addRow();
+    void addColumn();
+
+    int index(int row, int col) const { return row * cols + col; }
+
+    // Update one cell, keeping need in sync.
+    void addAllocation(int row, int col, int delta);
+    void setMaxClaim(int row, int col, int maxCount);
+    void addRequest(int row, int col, int delta) { request[index(row, col)] += delta; }
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// Forward declaration.
+class ResourceManager;
+
+// Runs deadlock detection and recovery on its own thread, so denied
+// requests in DETECT mode only queue the waiter and return.
+// Detection runs every 'period' ms, and/or as soon as 'waits' new waits
+// have been queued since the last run (0 disables either trigger).
+class BackgroundDetector
+{
+private:
+    thread worker;
+    mutex wakeLock;
+    condition_variable wake;
+    bool running = false;
+    bool stopping = false;
+    bool reconfigured = false;
+    int periodMs = 100;
+    int waitTrigger = 0;
+    int newWaits = 0;
+
+    void run(ResourceManager &rm);
+
+    // One detection pass (takes the state lock).
+    void detect(ResourceManager &rm);
+
+public:
+    // Metrics (read under the state lock).
+    long long runs = 0;               // Detection passes.
+    long long deadlocksDetected = 0;  // Cycles found (one per recovery).
+    long long lastLatencyUs = 0;      // Cycle formation -> detection.
+    long long maxLatencyUs = 0;
+    long long totalLatencyUs = 0;
+    long long latencySamples = 0;
+
+    long long averageLatencyUs() const { return latencySamples ? totalLatencyUs / latencySamples : 0; }
+
+    ~BackgroundDetector() { stop(); }
+
+    // Start the thread (switches rm to concurrent mode). Call from the
+    // thread that owns rm, while no other thread is using it.
+    void start(ResourceManager &rm);
+    void stop();
+    bool isRunning() const { return running; }
+
+    // Change the triggers (also while running).
+    void configure(int period, int waits);
+    int getPeriod() const { return periodMs; }
+    int getWaitTrigger() const { return waitTrigger; }
+
+    // Called by ResourceManager when a request starts waiting.
+    void noteWait();
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "ResourceManager.h"
+
+using namespace std;
+
+// Compact binary engine protocol (start the engine with --binary).
+//
+// Every frame is a u32 payload length followed by the payload.
+// All integers are little-endian.
+//
+// Input payload: one or more 16-byte command records, applied as a batch:
+//   u8 type (same letters as the text protocol), u8 sub, u16 reserved,
+//   i32 a, i32 b, i32 c
+//     P: a = pid               R: a = rid, b = total
+//     M: a = pid, b = rid, c = max
+//     E: sub 0 = REQUEST, 1 = RELEASE; a = pid, b = rid, c = count
+//        sub 2 = part of an all-or-nothing REQUEST; consecutive sub-2
+//        records for the same pid form one request vector
+//     S: sub 0 = DETECT, 1 = AVOID
+//     D: sub 0 = OFF, 1 = ON (a = full snapshot period), 2 = FULL
+//     O: sub 0 = SAFETY (a: 0 SWEEP, 1 INDEXED, 2 VERIFY)
+//        sub 1 = LOG    (a: 0 OFF, 1 SUMMARY, 2 FULL)
+//        sub 2 = EMIT   (a: 0 AUTO, 1 MANUAL)
+//        sub 3 = DETECTION (a: 0 INLINE, 1 BACKGROUND)
+//        sub 4 = DETECTION_PERIOD (a = ms), sub 5 = DETECTION_WAITS (a = n)
+//        sub 6 = DETECTION_THREADS (a = n)
+//        sub 7 = DETECTOR (a: 0 GRAPH, 1 REDUCTION)
+//        sub 8 = VICTIM_COST (a: 0 DEFAULT, 1 PRIORITY, 2 HELD, 3 WAIT, 4 ROLLBACKS)
+//        sub 9 = PREEMPTION (a: 0 FULL, 1 PARTIAL)
+//        sub 10 = MAX_ROLLBACKS (a = n, 0 = no cap)
+//        sub 11 = CLOCK (a: 0 WALL, 1 MONOTONIC, 2 VIRTUAL)
+//        sub 12 = AGING_THRESHOLD (a = clock units, > 0)
+//     T: a = ticks to advance virtual time (> 0)
+//     X, C: no fields
+//
+// Output payload: u8 kind (1 full, 2 delta, 3 error), u8 flags
+// (bit 0 = deadlock), u16 reserved, u32 seq, then:
+//   error: u32 length, message bytes
+//   state: u32 nResources, { i32 id, i32 total, i32 available }
+//          u32 nProcesses, { i32 id, i32 priority,
+//                            u32 nHeld, { i32 rid, i32 count },
+//                            u32 nMax,  { i32 rid, i32 count },
+//                            u32 nCheckpoint, { i32 rid, i32 count } }
+//          u32 nQueues,    { i32 rid, u32 nWaiters, { i32 pid, i32 count } }
+//          u32 nDeadlocked, { i32 pid }
+//          u32 nMetrics,   { i64 value }  (safety cache hits, misses,
+//                          detection runs, deadlocks detected, detection
+//                          latency us: last, max, average)
+//          u32 nLog,       { u32 length, bytes }
+// A delta carries only changed resources/processes/queues; a changed
+// queue is sent whole and replaces the receiver's copy.
+
+enum class BinaryFrameKind : uint8_t
+{
+    FULL = 1,
+    DELTA = 2,
+    ERROR = 3
+};
+
+// One fixed-width input record.
+struct BinaryCommand
+{
+    uint8_t type;
+    uint8_t sub;
+    int32_t a, b, c;
+};
+
+// Size of one record on the wire.
+const size_t BINARY_COMMAND_SIZE = 16;
+
+// Largest accepted input frame.
+const uint32_t BINARY_MAX_FRAME = 16 * 1024 * 1024;
+
+// Reads one frame. Returns false on EOF or broken framing.
+bool readBinaryFrame(istream &in, vector<BinaryCommand> &commands);
+
+// Writes a state frame (full, or only what rm.changes recorded).
+void writeBinaryState(ostream &out, ResourceManager &rm, bool full, uint32_t seq);
+
+// Writes an error frame.
+void writeBinaryError(ostream &out, const string &message);
+
+// Switch stdin/stdout to binary mode (matters on Windows).
+void setBinaryStdio();
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <mutex>
+
+using namespace std;
+
+// Records which processes, resources and wait queues changed
+// since the last state emission (for delta output).
+class ChangeTracker
+{
+private:
+    // Flags are atomic so re-marking an already flagged slot (the common
+    // case on the concurrent fast path) takes no lock. They only grow
+    // when a slot is first marked, which happens under the exclusive lock.
+    deque<atomic<char>> processFlags, resourceFlags, queueFlags;
+    vector<int> processes, resources, queues; // Slots, in first-change order.
+    mutex markLock;
+
+    void mark(deque<atomic<char>> &flags, vector<int> &changed, int slot);
+
+public:
+    // Serialize marks for concurrent writers (see EventLog::synchronized).
+    bool synchronized = false;
+
+    void markProcess(int slot) { mark(processFlags, processes, slot); }
+    void markResource(int slot) { mark(resourceFlags, resources, slot); }
+    void markWaitQueue(int resourceSlot) { mark(queueFlags, queues, resourceSlot); }
+
+    const vector<int> &changedProcesses() const { return processes; }
+    const vector<int> &changedResources() const { return resources; }
+    const vector<int> &changedWaitQueues() const { return queues; }
+
+    bool empty() const { return processes.empty() && resources.empty() && queues.empty(); }
+    void clear();
+};
@@ -1,19 +1,106 @@
 #pragma once
 
 #include <vector>
+#include <memory>
+#include <unordered_set>
+#include "ThreadPool.h"
 
 using namespace std;
 
-// Forward declaration.
+// Forward declarations.
 class ResourceManager;
+class AllocationMatrices;
+
+// Which safe-sequence search the Banker's check uses.
+enum class SafetyEngine
+{
+    SWEEP,  // Classic: sweep unfinished processes until none fits. O(n^2 * m).
+    INDEXED // Per-resource sorted need queues. ~O(n * m log n).
+};
+
+// How DETECT mode decides a deadlock exists.
+enum class DetectionEngine
+{
+    GRAPH,    // Cycle in the wait-for graph (exact for single-instance resources).
+    REDUCTION // Coffman/Holt reduction over Available/Allocation/Request (counted resources).
+};
 
 // Detects or avoids deadlocks.
 class DeadlockDetector
 {
+private:
+    // Scratch space for the safety check (reused between calls).
+    vector<int> work;
+    vector<char> finish;
+    vector<int> safeSequence; // Process slots.
+
+    // Scratch space for the indexed engine.
+    vector<int> blockedCount;                  // Resources still blocking each process.
+    vector<vector<pair<int, int>>> needQueues; // Per resource: sorted <Need, Slot>.
+    vector<int> queueHeads;
+    vector<int> ready;
+
+    // Last safe sequence found, still valid for the current state.
+    vector<int> cachedSequence;
+    vector<int> cachedPosition; // Slot -> index in cachedSequence.
+    bool cacheValid = false;
+
+    // Reduction: process slots that could not be reduced.
+    vector<int> unreduced;
+
+    // Coffman/Holt reduction; fills 'unreduced'. Slots marked in
+    // 'rolledBack' count as already reduced (their holdings returned).
+    void reduce(ResourceManager &rm, const vector<char> *rolledBack = nullptr);
+
+    // Workers for the component search (none = serial).
+    unique_ptr<ThreadPool> pool;
+
+    // Safe-sequence searches. Fill safeSequence, return the verdict.
+    bool sweepSafety(const AllocationMatrices &mx);
+    bool indexedSafety(const AllocationMatrices &mx);
+    bool runSafety(SafetyEngine engine, const AllocationMatrices &mx, ResourceManager &rm);
+
 public:
+    SafetyEngine safetyEngine = SafetyEngine::SWEEP;
+    DetectionEngine detectionEngine = DetectionEngine::GRAPH;
+
+    // Run both engines and log any disagreement in verdicts.
+    bool verifySafetyEngines = false;
+
+    // Safety cache statistics.
+    long long safetyCacheHits = 0;
+    long long safetyCacheMisses = 0;
+
     // Banker's Algorithm (avoidance).
     bool isSafeState(ResourceManager &rm);
 
-    // Wait-for graph (detection).
-    bool hasCycle(ResourceManager &rm);
+    // Safety check after tentatively granting 'count' of resource slot
+    // 'col' to process slot 'row'. Reuses the cached safe sequence when
+    // it still holds, otherwise runs the full check.
+    bool isSafeAfterGrant(ResourceManager &rm, int row, int col, int count);
+
+    // Call when max claims or the set of processes/resources change.
+    void invalidateSafetyCache() { cacheValid = false; }
+
+    // Detection with the selected engine.
+    bool hasDeadlock(ResourceManager &rm);
+
+    // Every deadlocked set of processes, sorted. GRAPH: the strongly
+    // connected components of the wait-for graph that contain a cycle.
+    // REDUCTION: one set, every process that can never be reduced.
+    // GRAPH falls back to REDUCTION while request vectors are queued.
+    vector<vector<int>> findDeadlocks(ResourceManager &rm);
+
+    // What would remain of 'deadlocks' (a findDeadlocks result) if the
+    // 'victims' were rolled back. Nothing is changed.
+    vector<vector<int>> findDeadlocksWithout(ResourceManager &rm, const unordered_set<int> &victims,
+                                             const vector<vector<int>> &deadlocks);
+
+    // Threads for findDeadlocks (1 = serial, the caller's thread).
+    void setDetectionThreads(int threads);
+    int getDetectionThreads() const { return pool ? pool->size() + 1 : 1; }
+
+    // Processes to report as deadlocked (sorted IDs): the members of
+    // every deadlocked component.
+    vector<int> deadlockedProcesses(ResourceManager &rm);
 };
\ No newline at end of file
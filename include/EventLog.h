@@ -0,0 +1,157 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <mutex>
+
+using namespace std;
+
+// How much gets logged.
+enum class LogLevel
+{
+    OFF,     // Nothing (hot path pays one branch).
+    SUMMARY, // Requests, releases, grants, denials, errors, recovery.
+    FULL     // Everything, including safety-check and aging details.
+};
+
+// Structured log events. The text for each lives in EventLog::format.
+enum class LogEvent : unsigned char
+{
+    // Setup.
+    STRATEGY_AVOID,
+    STRATEGY_DETECT,
+    SAFETY_ENGINE, // a = SafetyEngine (2 = VERIFY)
+    DUPLICATE_PROCESS, // a = pid
+    DUPLICATE_RESOURCE, // a = rid
+    MAX_CLAMPED, // a = pid, b = max, c = rid, d = total
+    MAX_DECLARED, // a = pid, b = rid, c = max
+    MAX_INVALID,
+
+    // Requests.
+    REQUEST, // a = pid, b = count, c = rid
+    REQUEST_INVALID_ID,
+    REQUEST_INVALID_COUNT,
+    REQUEST_NO_MAX, // a = pid, b = rid
+    REQUEST_EXCEEDS_MAX, // a = pid
+    REQUEST_VECTOR, // a = pid, b = parts (VECTOR_PARTs follow)
+    VECTOR_PART, // a = count, b = rid
+    VECTOR_DUPLICATE, // a = rid
+    VECTOR_ALREADY_QUEUED, // a = pid
+    ALREADY_WAITING, // a = pid, b = rid
+    TENTATIVE_ALLOCATE,
+    GRANTED_SAFE,
+    ROLLBACK_UNSAFE,
+    DENIED_UNSAFE, // a = pid
+    DENIED_MUST_WAIT, // a = pid
+    GRANTED,
+    DENIED_WAITS, // a = pid
+    POST_RECOVERY_CHECK,
+    RECOVERY_CRITICAL,
+
+    // Releases and wait lists.
+    RELEASE, // a = pid, b = count, c = rid
+    RELEASE_INVALID_ID,
+    RELEASE_INVALID_COUNT,
+    RELEASED, // a = rid, b = available
+    RELEASE_TOO_MANY, // a = pid, b = count, c = rid, d = held
+    CHECK_WAITS, // a = rid, b = available
+    TENTATIVE_GRANT_WAITER, // a = pid
+    WAITER_GRANTED_SAFE, // a = count, b = rid, c = pid
+    WAITER_UNSAFE, // a = pid
+    WAITER_GRANTED, // a = count, b = rid, c = pid
+    VECTOR_WAITER_GRANTED, // a = pid, b = parts
+    AGING_CHECK,
+
+    // Banker's.
+    ALLOC_EXCEEDS_MAX, // a = pid
+    SAFETY_DISAGREE,
+    NOT_SAFE,
+    SAFE, // a = sequence length (SEQUENCE_ITEMs follow)
+    SEQUENCE_ITEM, // a = pid
+    SAFE_CACHED,
+
+    // Recovery.
+    DEADLOCK_DETECTED,
+    RECOVERY_NO_MEMBERS,
+    ANALYZING_VICTIMS,
+    VICTIM_COST, // a = pid, b = cost * 1000
+    VICTIM_INELIGIBLE, // a = pid, b = rollbacks
+    VICTIM_CAP_WAIVED, // a = pid
+    RECOVERY_NO_VICTIM,
+    RECOVERY_VICTIM_MISSING, // a = pid
+    RECOVERY_PLAN, // a = victims
+    VICTIM_SELECTED, // a = pid, b = cost * 1000
+    NOTHING_PREEMPTED, // a = pid
+    PREEMPTING, // a = count, b = rid, c = pid
+    REMOVING_FROM_WAITS, // a = pid
+    REQUEUED, // a = pid, b = count, c = rid
+    RECOVERY_SUCCESS, // a = pid
+    RECOVERY_DETECT_ONLY,
+    DETECTION_INLINE,
+    DETECTION_BACKGROUND, // a = period ms, b = wait trigger
+    DEADLOCK_FOUND_BACKGROUND, // a = latency us
+    DETECTION_THREADS, // a = threads
+    DETECTION_ENGINE, // a = DetectionEngine
+    VICTIM_COST_MODEL, // a = VictimCostModel
+    PREEMPTION_MODE, // a = 1 partial, 0 full
+    ROLLBACK_CAP, // a = max rollbacks (0 = none)
+
+    // Aging.
+    CLOCK_SOURCE, // a = ClockSource
+    CLOCK_ADVANCED, // a = ticks
+    CLOCK_NOT_VIRTUAL,
+    AGING_THRESHOLD, // a = threshold
+    AGING_STARTED, // a = pid
+    AGING_BOOST, // a = pid, b = priority
+    AGING_STOPPED // a = pid
+};
+
+// One log entry: event code plus integer fields.
+struct LogRecord
+{
+    LogEvent event;
+    int a, b, c, d;
+};
+
+// Preallocated ring buffer of log records.
+// Nothing is formatted until the output stage asks for text.
+class EventLog
+{
+private:
+    vector<LogRecord> ring;
+    size_t head = 0;  // Oldest record.
+    size_t count = 0; // Records in the ring.
+    long long dropped = 0;
+    mutex pushLock;
+
+    void push(LogEvent event, int a, int b, int c, int d);
+
+public:
+    LogLevel level = LogLevel::FULL;
+
+    // Serialize record() for concurrent writers (ResourceManager's
+    // concurrent mode). Readers must still exclude writers.
+    bool synchronized = false;
+
+    EventLog(size_t capacity = 4096);
+
+    // Record an event (no-op if filtered out by the level).
+    void record(LogEvent event, int a = 0, int b = 0, int c = 0, int d = 0)
+    {
+        if (level != LogLevel::OFF)
+            push(event, a, b, c, d);
+    }
+
+    // Level an event is logged at.
+    static LogLevel levelOf(LogEvent event);
+
+    bool empty() const { return count == 0 && dropped == 0; }
+
+    // Text for a single record.
+    static string format(const LogRecord &record);
+
+    // Format every buffered record, oldest first.
+    vector<string> formatAll() const;
+
+    void clear();
+};
@@ -12,7 +12,9 @@ class Process
 public:
     int id;
     int priority;
-    long long waitStartTime;
+    long long waitStartTime; // Aging timer (restarts on each boost).
+    long long waitingSince;  // Start of the current wait.
+    int rollbackCount; // Times preempted by recovery.
 
     // <ResourceID, Count>
     map<int, int> resourcesHeld;
@@ -20,6 +22,11 @@ public:
     // <ResourceID, MaxCount>
     map<int, int> maxResourcesNeeded;
 
+    // <ResourceID, Count> held before recovery first rolled it back.
+    // What is missing from it is requeued; it is cleared once the process
+    // holds all of it again, or releases something itself.
+    map<int, int> checkpoint;
+
     Process(int processId);
     void increasePriority();
     void resetWaitTime();
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <map>
+#include <vector>
+#include <functional>
+#include <unordered_set>
 
 using namespace std;
 
@@ -8,18 +11,75 @@ using namespace std;
 class ResourceManager;
 class Process;
 
+// Terms of the victim cost. The cost is their weighted sum; the
+// cheapest deadlocked process is preempted first. History terms make a
+// process that keeps losing (or has waited long) progressively dearer.
+struct VictimCostWeights
+{
+    double typesHeld = 1;     // Distinct resources held.
+    double instancesHeld = 1; // Instances held.
+    double priority = -1;     // Current (aged) priority.
+    double waitTime = 0.1;    // Current wait, in clock units (see SimClock).
+    double rollbacks = 2;     // Times already preempted.
+};
+
+// Named weightings for 'O VICTIM_COST'.
+enum class VictimCostModel
+{
+    DEFAULT,   // Held - priority + rollback and wait history.
+    PRIORITY,  // Lowest priority first.
+    HELD,      // Fewest instances held (least work lost).
+    WAIT,      // Shortest wait so far.
+    ROLLBACKS  // Least often preempted.
+};
+
+// Custom cost; replaces the weighted sum when set.
+using VictimCostFunction = function<double(ResourceManager &, const Process &)>;
+
 // Handles deadlock recovery actions.
 class RecoveryAgent
 {
 private:
     Process *lastVictimProcess = nullptr;
+    vector<int> lastVictims;
     map<int, int> lastVictimPreemptedResources;
 
+    // Greedy plan: victim IDs that together break every deadlock.
+    vector<int> planVictims(ResourceManager &rm, const vector<vector<int>> &deadlocks, map<int, double> &costs);
+
+    // Instances of a resource the surviving deadlock members still lack.
+    int shortfall(ResourceManager &rm, int resourceId, int victimId, const unordered_set<int> &survivors);
+
+    // Below the rollback cap (or no cap set).
+    bool isEligible(const Process &p) const;
+
+    // Roll one victim back to what the deadlock does not need. Returns
+    // false if nothing was preempted.
+    bool rollBack(ResourceManager &rm, int victimId, double cost, const unordered_set<int> &survivors,
+                  bool partial);
+
 public:
-    // Attempt recovery. Returns true on success.
-    bool initiateRecovery(ResourceManager &rm);
+    VictimCostWeights costWeights;
+    VictimCostModel costModel = VictimCostModel::DEFAULT;
+    VictimCostFunction costFunction;
+
+    // Partial: preempt only what the surviving members wait for and
+    // requeue it for the victim. Full: preempt everything, requeue nothing.
+    bool partialPreemption = true;
+
+    // Rollbacks after which a process is no longer picked while another
+    // member of its deadlock is still eligible (0 = no cap).
+    int maxRollbacks = 0;
+
+    void setCostModel(VictimCostModel model);
+    double victimCost(ResourceManager &rm, const Process &p);
+
+    // Attempt recovery. Returns true if any victim was preempted.
+    // 'fullPreemption' overrides partialPreemption for this recovery.
+    bool initiateRecovery(ResourceManager &rm, bool fullPreemption = false);
 
     // Get results of last recovery.
     Process *getVictimProcess();
-    map<int, int> getPreemptedResources();
-};
\ No newline at end of file
+    const vector<int> &getVictims() const { return lastVictims; }
+    map<int, int> getPreemptedResources(); // Summed over all victims.
+};
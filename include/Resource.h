@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <map>
+#include <atomic>
 
 using namespace std;
 
@@ -10,7 +12,14 @@ class Resource
 public:
     int id;
     int totalInstances;
-    int availableInstances;
+
+    // Atomic so concurrent DETECT grants can claim instances with a CAS.
+    atomic<int> availableInstances;
+
+    // Reverse index: <ProcessID, Count> of current holders.
+    map<int, int> holders;
 
     Resource(int resourceId, int totalInstances);
+    Resource(const Resource &other);
+    Resource &operator=(const Resource &other);
 };
\ No newline at end of file
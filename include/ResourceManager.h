@@ -1,24 +1,30 @@
 #pragma once
 
 #include <vector>
+#include <deque>
 #include <map>
-#include <list>
+#include <unordered_map>
 #include <string>
+#include <array>
+#include <mutex>
 #include "Process.h"
 #include "Resource.h"
 #include "DeadlockDetector.h"
 #include "RecoveryAgent.h"
 #include "StarvationGuardian.h"
+#include "WaitForGraph.h"
+#include "WaitQueue.h"
+#include "AllocationMatrices.h"
+#include "EventLog.h"
+#include "ChangeTracker.h"
+#include "StateGate.h"
+#include "BackgroundDetector.h"
+#include "SimClock.h"
 
 using namespace std;
 
-// Info on a waiting process.
-struct WaitingInfo
-{
-    int processId;
-    int count;
-    WaitingInfo(int pId, int c) : processId(pId), count(c) {}
-};
+// An all-or-nothing request: <ResourceID, Count> per resource.
+using RequestVector = vector<pair<int, int>>;
 
 // Enum for strategy selection.
 enum class DeadlockStrategy
@@ -28,28 +34,118 @@ enum class DeadlockStrategy
 };
 
 // Main class to manage the simulation.
+//
+// Concurrent mode (setConcurrent): requestResource/releaseResource may be
+// called from many threads. DETECT grants that fit (with nobody queued on
+// the resource) and releases with no waiters take the shared side of the
+// state gate, claim instances with a CAS on availableInstances, and update
+// holdings under striped per-process and per-resource locks. Anything
+// touching wait queues, the wait-for graph, the Banker's check or recovery
+// takes the gate exclusively.
 class ResourceManager
 {
+private:
+    static const int LOCK_STRIPES = 64;
+
+    bool concurrent = false;
+    StateGate stateGate;
+    array<mutex, LOCK_STRIPES> processStripes;
+    array<mutex, LOCK_STRIPES> resourceStripes;
+
+    // Waiters across all queues (changed only under the exclusive lock).
+    int totalWaiters = 0;
+
+    // Next wait-queue sequence number (orders equal-priority waiters).
+    long long nextWaitSeq = 0;
+
+    // Bookkeeping for a grant whose instances were already claimed.
+    void recordGrant(Process *process, Resource *resource, int count);
+
+    // Fast paths (shared side of the gate held). Return false to fall back to the
+    // serialized path, which then handles the call from scratch.
+    bool tryFastRequest(int processId, int resourceId, int count);
+    bool tryFastRelease(int processId, int resourceId, int count);
+
+    // Serialized request/release logic.
+    bool requestLocked(int processId, int resourceId, int count);
+    bool releaseLocked(int processId, int resourceId, int count);
+    bool requestVectorLocked(int processId, const RequestVector &parts);
+
+    // <ProcessID, Parts> of queued request vectors. Each part is also a
+    // 'grouped' entry in its resource's wait queue.
+    unordered_map<int, RequestVector> queuedVectors;
+
+    // Every part fits what is available.
+    bool vectorFits(const RequestVector &parts);
+
+    // Grant every part of a vector that fits; in AVOID, only if the whole
+    // grant is safe (otherwise rolled back). Returns false if rolled back.
+    bool grantVector(Process *process, const RequestVector &parts);
+
+    // Dequeue every part of a process's queued vector.
+    void dequeueVector(int processId);
+
 public:
-    vector<Process> processes;
-    vector<Resource> resources;
+    // Deques keep element addresses stable as they grow,
+    // so pointers from the finders stay valid.
+    deque<Process> processes;
+    deque<Resource> resources;
+
+    // <ID, Slot> indices into the deques above.
+    unordered_map<int, int> processSlots;
+    unordered_map<int, int> resourceSlots;
+
+    // <ResourceID, Waiters in service order>
+    map<int, WaitQueue> waitingProcesses;
+
+    // Allocation / max claim / need, updated in place (Banker's).
+    AllocationMatrices matrices;
 
-    // <ResourceID, List of Waiting Processes>
-    map<int, list<WaitingInfo>> waitingProcesses;
+    // Live wait-for graph (waiter -> holder).
+    WaitForGraph waitForGraph;
 
     // Component modules.
     DeadlockDetector detector;
     RecoveryAgent recoveryAgent;
     StarvationGuardian starvationGuardian;
 
+    // Time source for aging and victim costs.
+    SimClock clock;
+
     // Current strategy.
     DeadlockStrategy strategy = DeadlockStrategy::DETECT;
 
-    // Log for the GUI.
-    list<string> logMessages;
+    // Structured log for the GUI (formatted at output time).
+    EventLog events;
+
+    // What changed since the last state emission.
+    ChangeTracker changes;
+
+    // Off-request-path detection (DETECT mode). Declared last so its
+    // thread is stopped before anything it uses is destroyed.
+    BackgroundDetector backgroundDetector;
 
     ResourceManager();
 
+    // Enable/disable concurrent mode. Call only while no other thread
+    // is using the manager.
+    void setConcurrent(bool enabled);
+    bool isConcurrent() const { return concurrent; }
+
+    // Some request vector is queued (its wait-for edges over-approximate).
+    bool hasQueuedVectors() const { return !queuedVectors.empty(); }
+
+    // Exclusive state lock in concurrent mode (empty lock otherwise).
+    // Hold it to read state, or to call the helpers below, from threads.
+    unique_lock<StateGate> lockState();
+
+    // Conservation check: for every resource, available + held == total
+    // and the holder index, process holdings and allocation matrix agree
+    // (as do the wait queues and request matrix).
+    // Returns false (and fills 'error') on the first violation. Takes the
+    // state lock itself.
+    bool checkInvariants(string &error);
+
     // Set the deadlock strategy.
     void setStrategy(DeadlockStrategy newStrategy);
 
@@ -62,23 +158,58 @@ public:
 
     // Core simulation events.
     bool requestResource(int processId, int resourceId, int count);
+
+    // All-or-nothing request for several resources: granted (AVOID: if
+    // the whole grant is safe) or queued as one unit on each of them.
+    bool requestResources(int processId, const RequestVector &parts);
     bool releaseResource(int processId, int resourceId, int count);
 
     // Find components.
     Process *findProcessById(int processId);
     Resource *findResourceById(int resourceId);
 
+    // State changes that keep the wait-for graph in sync.
+    void grantInstances(Process *process, Resource *resource, int count);
+    void reclaimInstances(Process *process, Resource *resource, int count);
+    // 'last': queue behind everyone already waiting (recovery requeues).
+    // 'grouped': part of a queued request vector.
+    bool addWaiter(int resourceId, int processId, int count, bool last = false, bool grouped = false);
+    WaitQueue::iterator removeWaiter(int resourceId, WaitQueue::iterator it);
+    void removeFromAllWaitLists(int processId);
+    void resetWaitTimer(Process *process);
+
+    // Re-key a process's waits after its priority changed.
+    void updateWaiterPriority(Process *process);
+
+    // Holders of a resource: <ProcessID, Count>.
+    const map<int, int> &getHolders(int resourceId);
+
+    // Recover from a detected deadlock and re-check the wait lists of
+    // what was preempted. Returns false if recovery failed.
+    // 'fullPreemption': see RecoveryAgent::initiateRecovery.
+    bool recoverFromDeadlock(bool fullPreemption = false);
+
+    // Inline detection: detect and recover until no deadlock is left
+    // (or recovery stops making progress).
+    void resolveDeadlocks();
+
     // Check wait list after a release.
     void checkWaitingProcesses(int resourceId);
 
     // Trigger aging check.
     void applyAgingToWaitingProcesses();
 
-    // Add a message to the GUI log.
-    void log(string message);
+    // Switch time source (running aging timers restart).
+    void setClockSource(ClockSource source);
+
+    // Fast-forward virtual time, then age. Returns false for real clocks.
+    bool advanceClock(long long ticks);
+
+    // Record a log event.
+    void log(LogEvent event, int a = 0, int b = 0, int c = 0, int d = 0) { events.record(event, a, b, c, d); }
 
     // Getters for Banker's Algorithm.
-    const vector<Process> &getProcesses() const { return processes; }
-    const vector<Resource> &getResources() const { return resources; }
-    const map<int, list<WaitingInfo>> &getWaitingProcesses() const { return waitingProcesses; }
+    const deque<Process> &getProcesses() const { return processes; }
+    const deque<Resource> &getResources() const { return resources; }
+    const map<int, WaitQueue> &getWaitingProcesses() const { return waitingProcesses; }
 };
\ No newline at end of file
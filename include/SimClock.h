@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+
+using namespace std;
+
+// Where simulation time comes from.
+enum class ClockSource
+{
+    WALL,      // System clock, seconds.
+    MONOTONIC, // Steady clock, seconds (immune to clock changes).
+    VIRTUAL    // Ticks: one per request/release, plus explicit advances.
+};
+
+// Time source for aging and victim wait costs. Virtual time depends only
+// on the command stream, so a trace replays identically at any speed.
+// Readings are never 0 (0 marks "not waiting" on Process).
+class SimClock
+{
+private:
+    // Atomic like ticks: requests advance the clock before taking the gate,
+    // so a concurrent CLOCK switch must not tear the read.
+    atomic<ClockSource> source{ClockSource::WALL};
+    atomic<long long> ticks{1};
+
+public:
+    void setSource(ClockSource newSource) { source.store(newSource, memory_order_relaxed); }
+    ClockSource getSource() const { return source.load(memory_order_relaxed); }
+    bool isVirtual() const { return getSource() == ClockSource::VIRTUAL; }
+
+    // Current time in the source's unit.
+    long long now() const;
+
+    // Advance virtual time (no-op for real clocks).
+    void advance(long long n = 1);
+};
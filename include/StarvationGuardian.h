@@ -1,14 +1,61 @@
 #pragma once
 
+#include <vector>
+#include <queue>
+#include <functional>
+
 using namespace std;
 
 // Forward declaration.
 class ResourceManager;
 
 // Prevents process starvation using Aging.
+//
+// Waiters are tracked as they join and leave wait queues, and each
+// waiting process has one aging deadline in a min-heap. applyAging
+// settles the processes whose waiting state changed since the last call
+// and pops only the deadlines that have expired, so a call costs
+// O(changes + expired * log P) instead of a scan of every process.
 class StarvationGuardian
 {
+private:
+    // Expiry of one aging timer; stale once the slot's epoch moves on.
+    struct Deadline
+    {
+        long long due;
+        int slot;
+        long long epoch;
+        bool operator>(const Deadline &other) const { return due > other.due; }
+    };
+    priority_queue<Deadline, vector<Deadline>, greater<Deadline>> deadlines;
+
+    // Per process slot.
+    vector<int> queuedOn;        // Wait queues the process is in.
+    vector<long long> epochs;    // Bumped whenever its timer starts or stops.
+
+    // Slots that started/stopped waiting (or had their timer reset)
+    // since the last applyAging.
+    vector<int> started, stopped;
+
+    void ensureSlot(int slot);
+
 public:
+    // Waiting time (in clock units) that earns one priority step.
+    // A change applies to timers started afterwards.
+    long long agingThreshold = 5;
+
+    // Queue membership changes (from ResourceManager).
+    void waiterAdded(int slot);
+    void waiterRemoved(int slot);
+
+    // A grant reset the timer; it restarts if the process still waits.
+    void timerReset(int slot);
+
+    // Restart every running timer (after the clock source changes).
+    void restartTimers(ResourceManager &rm);
+
+    bool isWaiting(int slot) const { return slot < (int)queuedOn.size() && queuedOn[slot] > 0; }
+
     // Check and boost priority of waiting processes.
     void applyAging(ResourceManager &rm);
-};
\ No newline at end of file
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+using namespace std;
+
+// Reader/writer gate for ResourceManager's concurrent mode.
+//
+// Readers (the lock-free fast paths) only bump a counter on their own
+// cache line, so uncontended readers on different cores share nothing.
+// A writer raises a flag and waits for the counters to drain; readers
+// that see the flag back out and queue behind the writer instead.
+// Satisfies BasicLockable for the writer side (unique_lock<StateGate>).
+class StateGate
+{
+private:
+    static const int READER_SLOTS = 64;
+
+    struct alignas(64) ReaderSlot
+    {
+        atomic<int> count{0};
+    };
+
+    array<ReaderSlot, READER_SLOTS> readers;
+    atomic<bool> writerActive{false};
+    mutex writerLock;
+
+    // Reader slot for the calling thread (fixed per thread).
+    static int readerSlot();
+
+public:
+    // Shared entry. Returns the slot to pass to exitShared, or -1 if a
+    // writer holds or is waiting for the gate.
+    int tryEnterShared();
+    void exitShared(int slot);
+
+    // Exclusive entry.
+    void lock();
+    void unlock();
+
+    // Scoped shared entry; check entered().
+    class Reader
+    {
+    private:
+        StateGate &gate;
+        int slot;
+
+    public:
+        explicit Reader(StateGate &g) : gate(g), slot(g.tryEnterShared()) {}
+        ~Reader()
+        {
+            if (slot >= 0)
+                gate.exitShared(slot);
+        }
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+        bool entered() const { return slot >= 0; }
+    };
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+// Fixed-size pool of worker threads.
+class ThreadPool
+{
+private:
+    vector<thread> workers;
+    deque<function<void()>> tasks;
+    mutex queueLock;
+    condition_variable wake;
+    bool stopping = false;
+
+    void work();
+
+public:
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int size() const { return workers.size(); }
+
+    // Run fn(i) for every i in [0, n) on the workers and the calling
+    // thread; returns once all calls have finished.
+    void parallelFor(int n, const function<void(int)> &fn);
+};
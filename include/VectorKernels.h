@@ -0,0 +1,25 @@
+#pragma once
+
+using namespace std;
+
+// Row kernels for the Banker's safety check.
+// AVX2 / SSE4.1 versions are picked at runtime when the CPU has them,
+// otherwise a portable scalar loop is used.
+
+// Is need[j] <= work[j] for every j < m?
+bool rowFits(const int *need, const int *work, int m);
+
+// work[j] += allocation[j] for every j < m.
+void rowAccumulate(int *work, const int *allocation, int m);
+
+// Kernel selection.
+enum class KernelSet
+{
+    SCALAR,
+    SSE41,
+    AVX2
+};
+KernelSet bestKernelSet();                // Best the CPU supports.
+KernelSet activeKernelSet();              // Currently in use.
+bool selectKernelSet(KernelSet kernels);  // False if unsupported.
+const char *kernelSetName(KernelSet kernels);
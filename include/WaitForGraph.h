@@ -0,0 +1,77 @@
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+// Forward declaration.
+class ThreadPool;
+
+// Persistent wait-for graph (waiter -> holder).
+// Kept up to date by ResourceManager as waits and holdings change.
+class WaitForGraph
+{
+private:
+    // <WaiterID, <HolderID, EdgeCount>>
+    // EdgeCount > 1 when a waiter waits on several resources held by the same holder.
+    unordered_map<int, unordered_map<int, int>> edges;
+
+    // Sources of edges added since they were last checked, with the time
+    // (steady clock, ns; 0 unless timed) each became pending.
+    // Any cycle in the graph passes through at least one of these.
+    unordered_map<int, long long> pendingSources;
+
+    // Pending-since time of the source the last cycle was found through.
+    long long cycleSince = 0;
+
+    // Scratch space for the search (reused between checks).
+    unordered_set<int> visited;
+    vector<int> stack;
+
+    // Is there a path from 'source' back to itself?
+    bool cycleThrough(int source);
+
+    // Dense (CSR) copy of the graph for the SCC search.
+    vector<int> nodeIds;              // Index -> process ID.
+    unordered_map<int, int> nodeIndex; // Process ID -> index.
+    vector<int> adjStart, adj;        // Successors of i: adj[adjStart[i] .. adjStart[i + 1]).
+
+    // Tarjan state, shared by all searches (each touches only its own nodes).
+    vector<int> order, low;
+    vector<char> onStack;
+
+    // All nodes, or only 'scope' (the subgraph it induces).
+    void buildSnapshot(const vector<int> *scope = nullptr);
+
+    // Iterative Tarjan over 'roots' and everything reachable from them.
+    // Appends each component that contains a cycle.
+    void tarjan(const vector<int> &roots, vector<vector<int>> &out);
+
+public:
+    // Stamp pending sources with the time they started waiting
+    // (for detection latency when detection runs in the background).
+    bool timed = false;
+
+    void addEdge(int waiterId, int holderId);
+    void removeEdge(int waiterId, int holderId);
+
+    // Incremental check: only explores from newly added edges.
+    bool hasCycle();
+
+    // When the last cycle found started forming: the time its pending
+    // member started waiting (steady clock, ns; needs 'timed').
+    long long cycleFormedAt() const { return cycleSince; }
+
+    // Every deadlocked component: strongly connected components with a
+    // cycle, members sorted by ID, components ordered by smallest member.
+    // With a pool, independent weakly connected components are searched
+    // in parallel (small graphs are always searched serially).
+    vector<vector<int>> deadlockedComponents(ThreadPool *pool = nullptr);
+
+    // Same, restricted to the subgraph induced by 'nodes' (serial).
+    vector<vector<int>> deadlockedComponentsAmong(const vector<int> &nodes);
+
+    const unordered_map<int, unordered_map<int, int>> &getEdges() const { return edges; }
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <set>
+#include <map>
+#include <unordered_map>
+#include <climits>
+
+using namespace std;
+
+// Info on a waiting process.
+struct WaitingInfo
+{
+    int processId;
+    int count;
+    int priority;  // Ordering key; follows the process's aged priority.
+    long long seq; // Enqueue order (lower = waiting longer).
+    bool grouped;  // Part of an all-or-nothing request vector.
+    WaitingInfo(int pId, int c, int prio = 0, long long s = 0, bool g = false)
+        : processId(pId), count(c), priority(prio), seq(s), grouped(g) {}
+};
+
+// Waiters on one resource, served highest priority first, then longest
+// waiting. Ordered set plus a process index: O(log n) insert, reprioritize
+// and remove, O(1) membership. Waiters are also bucketed by requested
+// count, so a release visits only the waiters it can satisfy.
+class WaitQueue
+{
+private:
+    struct ServiceOrder
+    {
+        bool operator()(const WaitingInfo &a, const WaitingInfo &b) const
+        {
+            if (a.priority != b.priority)
+                return a.priority > b.priority;
+            return a.seq < b.seq;
+        }
+    };
+    using Entries = set<WaitingInfo, ServiceOrder>;
+
+    Entries entries;
+    unordered_map<int, Entries::iterator> byProcess;
+
+    // <Count, Waiters asking for exactly that many, in service order>
+    map<int, Entries> byCount;
+
+    void unbucket(const WaitingInfo &info);
+
+public:
+    using iterator = Entries::const_iterator;
+
+    // Enqueue. Returns false if the process is already waiting here.
+    bool push(const WaitingInfo &info);
+
+    // Dequeue. Returns the next position in service order.
+    iterator erase(iterator it);
+
+    // Re-key a waiter after its priority changed (keeps its age).
+    bool setPriority(int processId, int priority);
+
+    bool contains(int processId) const { return byProcess.count(processId) > 0; }
+    iterator find(int processId) const;
+
+    // Smallest outstanding request (INT_MAX if empty).
+    int smallestRequest() const { return byCount.empty() ? INT_MAX : byCount.begin()->first; }
+
+    // First waiter after 'after' in service order (from the front if null)
+    // asking for at most 'available'; end() if none. Looks at one bucket
+    // per distinct count that fits.
+    iterator nextFitting(int available, const WaitingInfo *after = nullptr) const;
+
+    // Lowest priority queued (0 if empty).
+    int lowestPriority() const { return entries.empty() ? 0 : entries.rbegin()->priority; }
+
+    iterator begin() const { return entries.begin(); }
+    iterator end() const { return entries.end(); }
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+};
@@ -1,8 +1,10 @@
 #include "../include/ResourceManager.h"
+#include "../include/BinaryProtocol.h"
 #include <iostream>
 #include <sstream>
 #include <string>
-#include <set> // <-- ADDED THIS INCLUDE
+#include <set>
+#include <vector>
 
 using namespace std;
 
@@ -16,74 +18,173 @@ void send_log(string message)
     cout << "LOG: " << message << endl;
 }
 
+// Set by --binary: errors and state go out as binary frames.
+static bool binaryProtocol = false;
+
 // Helper to send an error message.
 void send_error(string message)
 {
-    cout << "ERR: " << message << endl;
+    if (binaryProtocol)
+        writeBinaryError(cout, message);
+    else
+        cout << "ERR: " << message << endl;
+}
+
+// Output settings for state emissions.
+struct StateOutput
+{
+    bool delta = false;     // Send only what changed (D ON).
+    int fullEvery = 100;    // Full snapshot every N emissions in delta mode.
+    int sinceFull = 0;
+    bool forceFull = false; // Next emission is a full snapshot (D FULL).
+    long long seq = 0;      // Emission number, for resync (delta mode only).
+    bool manual = false;    // Emit only when asked with X (O EMIT MANUAL).
+};
+
+// One resource as JSON.
+void printResourceJson(ResourceManager &rm, const Resource &r)
+{
+    cout << "{\"id\": " << r.id << ", \"total\": " << r.totalInstances
+         << ", \"available\": " << r.availableInstances;
+
+    // Holders (from the reverse index)
+    cout << ", \"holders\": [";
+    bool firstHolder = true;
+    for (const auto &pair : rm.getHolders(r.id))
+    {
+        if (!firstHolder)
+            cout << ", ";
+        cout << "{\"id\": " << pair.first << ", \"count\": " << pair.second << "}";
+        firstHolder = false;
+    }
+    cout << "]}";
+}
+
+// One process as JSON.
+void printProcessJson(const Process &p)
+{
+    cout << "{\"id\": " << p.id << ", \"priority\": " << p.priority;
+
+    // Held resources
+    cout << ", \"held\": [";
+    bool firstHeld = true;
+    for (const auto &pair : p.resourcesHeld)
+    {
+        if (!firstHeld)
+            cout << ", ";
+        cout << "{\"id\": " << pair.first << ", \"count\": " << pair.second << "}";
+        firstHeld = false;
+    }
+    cout << "]"; // End held
+
+    // Max needs
+    cout << ", \"max_need\": [";
+    bool firstMax = true;
+    for (const auto &pair : p.maxResourcesNeeded)
+    {
+        if (!firstMax)
+            cout << ", ";
+        cout << "{\"id\": " << pair.first << ", \"count\": " << pair.second << "}";
+        firstMax = false;
+    }
+    cout << "]"; // End max_need
+
+    // Holdings to restore after a recovery rollback
+    cout << ", \"checkpoint\": [";
+    bool firstCheckpoint = true;
+    for (const auto &pair : p.checkpoint)
+    {
+        if (!firstCheckpoint)
+            cout << ", ";
+        cout << "{\"id\": " << pair.first << ", \"count\": " << pair.second << "}";
+        firstCheckpoint = false;
+    }
+    cout << "]"; // End checkpoint
+
+    cout << "}"; // Close process
+}
+
+// Deadlock cycle, metrics and log: sent in full with every emission.
+void printStateTail(ResourceManager &rm)
+{
+    // Deadlock cycle (for highlighting)
+    cout << "\"deadlock_cycle\": [";
+    if (rm.strategy == DeadlockStrategy::DETECT)
+    {
+        bool firstCycle = true;
+        for (int id : rm.detector.deadlockedProcesses(rm))
+        {
+            if (!firstCycle)
+                cout << ", ";
+            cout << id;
+            firstCycle = false;
+        }
+    }
+    cout << "], \n"; // End deadlock_cycle
+
+    // Metrics
+    const BackgroundDetector &bg = rm.backgroundDetector;
+    cout << "\"metrics\": {\"safety_cache_hits\": " << rm.detector.safetyCacheHits
+         << ", \"safety_cache_misses\": " << rm.detector.safetyCacheMisses
+         << ", \"detection_runs\": " << bg.runs
+         << ", \"deadlocks_detected\": " << bg.deadlocksDetected
+         << ", \"detection_latency_us_last\": " << bg.lastLatencyUs
+         << ", \"detection_latency_us_max\": " << bg.maxLatencyUs
+         << ", \"detection_latency_us_avg\": " << bg.averageLatencyUs() << "}, \n";
+
+    // Log messages
+    cout << "\"log\": [";
+    bool firstLog = true;
+    for (const auto &msg : rm.events.formatAll())
+    {
+        if (!firstLog)
+            cout << ",";
+        string escaped_msg = msg;
+        size_t pos = 0;
+        while ((pos = escaped_msg.find('"', pos)) != string::npos)
+        {
+            escaped_msg.replace(pos, 1, "\\\"");
+            pos += 2;
+        }
+        cout << "\"" << escaped_msg << "\"";
+        firstLog = false;
+    }
+    rm.events.clear(); // Clear log after sending.
+    cout << "]\n"; // End log
 }
 
 // Prints the entire system state as JSON for Python to parse.
-void printStateAsJson(ResourceManager &rm)
+// In delta mode (seq >= 0) the snapshot is tagged for resync.
+void printStateAsJson(ResourceManager &rm, long long seq = -1)
 {
-    cout << "---STATE_BEGIN---" << endl; // Start delimiter.
+    cout << "---STATE_BEGIN---\n"; // Start delimiter.
+    cout << "{";
+    if (seq >= 0)
+        cout << "\"seq\": " << seq << ", \"type\": \"full\", ";
 
     // Resources
-    cout << "{\"resources\": [";
+    cout << "\"resources\": [";
     for (size_t i = 0; i < rm.resources.size(); ++i)
     {
-        auto &r = rm.resources[i];
-        cout << "{\"id\": " << r.id << ", \"total\": " << r.totalInstances
-             << ", \"available\": " << r.availableInstances << "}";
+        printResourceJson(rm, rm.resources[i]);
         if (i < rm.resources.size() - 1)
             cout << ",";
     }
-    cout << "], " << endl; // End resources
+    cout << "], \n"; // End resources
 
     // Processes
     cout << "\"processes\": [";
     for (size_t i = 0; i < rm.processes.size(); ++i)
     {
-        auto &p = rm.processes[i];
-        cout << "{\"id\": " << p.id << ", \"priority\": " << p.priority;
-
-        // Held resources
-        cout << ", \"held\": [";
-        bool firstHeld = true;
-        // CHANGED: Replaced C++17 structured binding
-        for (const auto &pair : p.resourcesHeld)
-        {
-            if (!firstHeld)
-                cout << ", ";
-            // CHANGED: Use pair.first and pair.second
-            cout << "{\"id\": " << pair.first << ", \"count\": " << pair.second << "}";
-            firstHeld = false;
-        }
-        cout << "]"; // End held
-
-        // Max needs
-        cout << ", \"max_need\": [";
-        bool firstMax = true;
-        // CHANGED: Replaced C++17 structured binding
-        for (const auto &pair : p.maxResourcesNeeded)
-        {
-            if (!firstMax)
-                cout << ", ";
-            // CHANGED: Use pair.first and pair.second
-            cout << "{\"id\": " << pair.first << ", \"count\": " << pair.second << "}";
-            firstMax = false;
-        }
-        cout << "]"; // End max_need
-
-        cout << "}"; // Close process
+        printProcessJson(rm.processes[i]);
         if (i < rm.processes.size() - 1)
             cout << ",";
     }
-    cout << "], " << endl; // End processes
+    cout << "], \n"; // End processes
 
     // Waiting processes (links for graph)
     cout << "\"waiting\": [";
     bool firstWait = true;
-    // CHANGED: Replaced C++17 structured binding
     for (const auto &pair : rm.waitingProcesses)
     {
         int resId = pair.first;
@@ -92,160 +193,680 @@ void printStateAsJson(ResourceManager &rm)
         {
             if (!firstWait)
                 cout << ",";
-            // CHANGED: Use resId (from pair.first) and info
             cout << "  {\"process_id\": " << info.processId << ", \"resource_id\": "
                  << resId << ", \"count\": " << info.count << "}";
             firstWait = false;
         }
     }
-    cout << "\n], " << endl; // End waiting (added newline for readability)
+    cout << "\n], \n"; // End waiting (added newline for readability)
 
-    // Deadlock cycle (for highlighting)
-    cout << "\"deadlock_cycle\": [";
-    if (rm.strategy == DeadlockStrategy::DETECT && rm.detector.hasCycle(rm))
+    printStateTail(rm);
+
+    cout << "}\n";               // End JSON object
+    cout << "---STATE_END---\n"; // End delimiter.
+}
+
+// Prints only what changed since the last emission.
+// Changed wait queues are sent whole; they replace the receiver's copy.
+void printDeltaAsJson(ResourceManager &rm, long long seq)
+{
+    cout << "---STATE_BEGIN---\n";
+    cout << "{\"seq\": " << seq << ", \"type\": \"delta\", ";
+
+    // Changed resources
+    cout << "\"resources\": [";
+    bool first = true;
+    for (int slot : rm.changes.changedResources())
+    {
+        if (!first)
+            cout << ",";
+        printResourceJson(rm, rm.resources[slot]);
+        first = false;
+    }
+    cout << "], \n";
+
+    // Changed processes
+    cout << "\"processes\": [";
+    first = true;
+    for (int slot : rm.changes.changedProcesses())
+    {
+        if (!first)
+            cout << ",";
+        printProcessJson(rm.processes[slot]);
+        first = false;
+    }
+    cout << "], \n";
+
+    // Changed wait queues
+    cout << "\"wait_queues\": [";
+    first = true;
+    for (int slot : rm.changes.changedWaitQueues())
     {
-        set<int> cycleProcs;
-        // CHANGED: Replaced C++17 structured binding
-        for (const auto &pair : rm.waitingProcesses)
+        int resId = rm.resources[slot].id;
+        if (!first)
+            cout << ",";
+        cout << "{\"resource_id\": " << resId << ", \"waiters\": [";
+        auto it = rm.waitingProcesses.find(resId);
+        if (it != rm.waitingProcesses.end())
         {
-            // CHANGED: Use pair.second
-            for (auto const &info : pair.second)
-                cycleProcs.insert(info.processId);
+            bool firstWaiter = true;
+            for (const auto &info : it->second)
+            {
+                if (!firstWaiter)
+                    cout << ", ";
+                cout << "{\"process_id\": " << info.processId << ", \"count\": " << info.count << "}";
+                firstWaiter = false;
+            }
         }
-        bool firstCycle = true;
-        for (int id : cycleProcs)
+        cout << "]}";
+        first = false;
+    }
+    cout << "], \n";
+
+    printStateTail(rm);
+
+    cout << "}\n";
+    cout << "---STATE_END---\n";
+}
+
+// Sends state in the negotiated form, then forgets tracked changes.
+void emitState(ResourceManager &rm, StateOutput &out)
+{
+    unique_lock<StateGate> guard = rm.lockState(); // Background detector.
+    if (!out.delta)
+    {
+        if (binaryProtocol)
+            writeBinaryState(cout, rm, true, out.seq++);
+        else
+            printStateAsJson(rm);
+    }
+    else if (out.forceFull || out.sinceFull >= out.fullEvery)
+    {
+        if (binaryProtocol)
+            writeBinaryState(cout, rm, true, out.seq++);
+        else
+            printStateAsJson(rm, out.seq++);
+        out.forceFull = false;
+        out.sinceFull = 0;
+    }
+    else
+    {
+        if (binaryProtocol)
+            writeBinaryState(cout, rm, false, out.seq++);
+        else
+            printDeltaAsJson(rm, out.seq++);
+        out.sinceFull++;
+    }
+    rm.changes.clear();
+    cout.flush(); // One flush per emission.
+}
+
+// Parses a non-negative option value.
+bool parseCount(const string &value, int &count)
+{
+    stringstream ss(value);
+    return (ss >> count) && ss.eof() && count >= 0;
+}
+
+// Detection options: DETECTION INLINE|BACKGROUND, DETECTION_PERIOD <ms>,
+// DETECTION_WAITS <n>, DETECTION_THREADS <n>.
+// Start/stop happen outside the state lock.
+bool setDetectionOption(ResourceManager &rm, const string &name, const string &value)
+{
+    BackgroundDetector &bg = rm.backgroundDetector;
+    int count = 0;
+    if (name == "DETECTION" && value == "BACKGROUND")
+        bg.start(rm);
+    else if (name == "DETECTION" && value == "INLINE")
+        bg.stop();
+    else if (name == "DETECTION_PERIOD" && parseCount(value, count))
+        bg.configure(count, bg.getWaitTrigger());
+    else if (name == "DETECTION_WAITS" && parseCount(value, count))
+        bg.configure(bg.getPeriod(), count);
+    else if (name == "DETECTION_THREADS" && parseCount(value, count) && count > 0)
+    {
+        unique_lock<StateGate> guard = rm.lockState();
+        rm.detector.setDetectionThreads(count);
+        rm.log(LogEvent::DETECTION_THREADS, count);
+        return true;
+    }
+    else
+        return false;
+
+    unique_lock<StateGate> guard = rm.lockState();
+    if (bg.isRunning())
+        rm.log(LogEvent::DETECTION_BACKGROUND, bg.getPeriod(), bg.getWaitTrigger());
+    else
+        rm.log(LogEvent::DETECTION_INLINE);
+    return true;
+}
+
+// Applies an engine option ("O <NAME> <VALUE>"). Returns false if unknown.
+bool setOption(ResourceManager &rm, StateOutput &output, const string &name, const string &value)
+{
+    if (name.compare(0, 9, "DETECTION") == 0)
+        return setDetectionOption(rm, name, value);
+    if (name == "CLOCK")
+    { // Aging time source: WALL, MONOTONIC or VIRTUAL (see 'T').
+        static const char *const sources[] = {"WALL", "MONOTONIC", "VIRTUAL"};
+        for (int i = 0; i < 3; ++i)
         {
-            if (!firstCycle)
-                cout << ", ";
-            cout << id;
-            firstCycle = false;
+            if (value == sources[i])
+            {
+                rm.setClockSource(static_cast<ClockSource>(i));
+                return true;
+            }
         }
+        return false;
     }
-    cout << "], " << endl; // End deadlock_cycle
 
-    // Log messages
-    cout << "\"log\": [";
-    bool firstLog = true;
-    for (const auto &msg : rm.logMessages)
+    unique_lock<StateGate> guard = rm.lockState();
+    if (name == "SAFETY")
+    { // Safe-sequence search: SWEEP, INDEXED, or VERIFY (run both, compare).
+        if (value == "SWEEP" || value == "INDEXED")
+        {
+            rm.detector.safetyEngine = (value == "SWEEP") ? SafetyEngine::SWEEP : SafetyEngine::INDEXED;
+            rm.detector.verifySafetyEngines = false;
+            rm.log(LogEvent::SAFETY_ENGINE, static_cast<int>(rm.detector.safetyEngine));
+        }
+        else if (value == "VERIFY")
+        {
+            rm.detector.verifySafetyEngines = true;
+            rm.log(LogEvent::SAFETY_ENGINE, 2);
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+    if (name == "DETECTOR")
+    { // DETECT engine: GRAPH (wait-for cycles) or REDUCTION (counted resources).
+        if (value == "GRAPH")
+            rm.detector.detectionEngine = DetectionEngine::GRAPH;
+        else if (value == "REDUCTION")
+            rm.detector.detectionEngine = DetectionEngine::REDUCTION;
+        else
+            return false;
+        rm.log(LogEvent::DETECTION_ENGINE, static_cast<int>(rm.detector.detectionEngine));
+        return true;
+    }
+    if (name == "VICTIM_COST")
+    { // Recovery victim weighting.
+        static const char *const models[] = {"DEFAULT", "PRIORITY", "HELD", "WAIT", "ROLLBACKS"};
+        for (int i = 0; i < 5; ++i)
+        {
+            if (value == models[i])
+            {
+                rm.recoveryAgent.setCostModel(static_cast<VictimCostModel>(i));
+                rm.log(LogEvent::VICTIM_COST_MODEL, i);
+                return true;
+            }
+        }
+        return false;
+    }
+    if (name == "PREEMPTION")
+    { // Recovery rollback: PARTIAL (requeue what was taken) or FULL.
+        if (value == "PARTIAL")
+            rm.recoveryAgent.partialPreemption = true;
+        else if (value == "FULL")
+            rm.recoveryAgent.partialPreemption = false;
+        else
+            return false;
+        rm.log(LogEvent::PREEMPTION_MODE, rm.recoveryAgent.partialPreemption ? 1 : 0);
+        return true;
+    }
+    if (name == "MAX_ROLLBACKS")
+    { // Rollbacks before a process stops being picked as victim (0 = no cap).
+        int count = 0;
+        if (!parseCount(value, count))
+            return false;
+        rm.recoveryAgent.maxRollbacks = count;
+        rm.log(LogEvent::ROLLBACK_CAP, count);
+        return true;
+    }
+    if (name == "AGING_THRESHOLD")
+    { // Clock units of waiting per priority step.
+        int count = 0;
+        if (!parseCount(value, count) || count == 0)
+            return false;
+        rm.starvationGuardian.agingThreshold = count;
+        rm.log(LogEvent::AGING_THRESHOLD, count);
+        return true;
+    }
+    if (name == "LOG")
+    { // Log verbosity: OFF, SUMMARY or FULL.
+        if (value == "OFF")
+            rm.events.level = LogLevel::OFF;
+        else if (value == "SUMMARY")
+            rm.events.level = LogLevel::SUMMARY;
+        else if (value == "FULL")
+            rm.events.level = LogLevel::FULL;
+        else
+            return false;
+        return true;
+    }
+    if (name == "EMIT")
+    { // State emission: AUTO (after every command) or MANUAL (only on X).
+        if (value != "AUTO" && value != "MANUAL")
+            return false;
+        output.manual = (value == "MANUAL");
+        return true;
+    }
+    return false;
+}
+
+// A parsed engine command.
+struct Command
+{
+    char type = 0;
+    int pId = 0, rId = 0, count = 0;
+    string word;  // S: strategy, E: action, O: option name, D: mode.
+    string value; // O: option value.
+    RequestVector parts; // E REQUEST with several pairs: <rid, count>, all or nothing.
+};
+
+// Parses one text command. On failure fills 'error' and returns false.
+bool parseCommand(const string &line, Command &cmd, string &error)
+{
+    stringstream ss(line);
+    ss >> cmd.type;
+
+    switch (cmd.type)
     {
-        if (!firstLog)
-            cout << ",";
-        string escaped_msg = msg;
-        size_t pos = 0;
-        while ((pos = escaped_msg.find('"', pos)) != string::npos)
+    case 'S': // Set Strategy
+        ss >> cmd.word;
+        return true;
+    case 'P': // Add Process
+        if (ss >> cmd.pId)
+            return true;
+        error = "Invalid Process ID";
+        return false;
+    case 'R': // Add Resource
+        if (ss >> cmd.rId >> cmd.count)
+            return true;
+        error = "Invalid Resource definition";
+        return false;
+    case 'M': // Declare Max Need
+        if (ss >> cmd.pId >> cmd.rId >> cmd.count)
+            return true;
+        error = "Invalid Max Need definition";
+        return false;
+    case 'E': // Execute Event: E <pid> REQUEST|RELEASE <rid> <count> [<rid> <count> ...]
+        if (ss >> cmd.pId >> cmd.word >> cmd.rId >> cmd.count)
         {
-            escaped_msg.replace(pos, 1, "\\\"");
-            pos += 2;
+            int rId = 0, count = 0;
+            while (ss >> rId)
+            {
+                if (!(ss >> count) || cmd.word != "REQUEST")
+                {
+                    error = "Invalid Event definition";
+                    return false;
+                }
+                if (cmd.parts.empty())
+                    cmd.parts.emplace_back(cmd.rId, cmd.count);
+                cmd.parts.emplace_back(rId, count);
+            }
+            if (ss.eof())
+                return true;
         }
-        cout << "\"" << escaped_msg << "\"";
-        firstLog = false;
+        error = "Invalid Event definition";
+        return false;
+    case 'O': // Set an engine Option
+        if (ss >> cmd.word >> cmd.value)
+            return true;
+        error = "Invalid option";
+        return false;
+    case 'T': // Advance virtual Time by n ticks
+        if (ss >> cmd.count && cmd.count > 0)
+            return true;
+        error = "Invalid tick count";
+        return false;
+    case 'D': // Delta output: D ON [fullEvery] | D OFF | D FULL (resync)
+        ss >> cmd.word;
+        if (cmd.word == "ON")
+            ss >> cmd.count; // Optional; stays 0 if absent.
+        return true;
+    default: // X, C, and unknown types (reported when executed).
+        return true;
     }
-    rm.logMessages.clear(); // Clear log after sending.
-    cout << "]" << endl;    // End log
+}
 
-    cout << "}" << endl;               // End JSON object
-    cout << "---STATE_END---" << endl; // End delimiter.
+// Applies one command. Returns false if it failed (error already sent).
+bool executeCommand(ResourceManager &rm, const Command &cmd, StateOutput &output)
+{
+    switch (cmd.type)
+    {
+    case 'S':
+        rm.setStrategy(cmd.word == "AVOID" ? DeadlockStrategy::AVOID : DeadlockStrategy::DETECT);
+        break;
+    case 'P':
+        rm.addProcess(Process(cmd.pId));
+        break;
+    case 'R':
+        rm.addResource(Resource(cmd.rId, cmd.count));
+        break;
+    case 'M':
+        rm.declareMaxResources(cmd.pId, cmd.rId, cmd.count);
+        break;
+    case 'E':
+        if (cmd.word == "REQUEST" && !cmd.parts.empty())
+            rm.requestResources(cmd.pId, cmd.parts);
+        else if (cmd.word == "REQUEST")
+            rm.requestResource(cmd.pId, cmd.rId, cmd.count);
+        else if (cmd.word == "RELEASE")
+            rm.releaseResource(cmd.pId, cmd.rId, cmd.count);
+        break;
+    case 'O':
+        if (!setOption(rm, output, cmd.word, cmd.value))
+        {
+            send_error("Invalid option");
+            return false;
+        }
+        break;
+    case 'D':
+        if (cmd.word == "ON")
+        {
+            if (cmd.count > 0)
+                output.fullEvery = cmd.count;
+            output.delta = true;
+            output.forceFull = true; // Start from a known baseline.
+        }
+        else if (cmd.word == "OFF")
+        {
+            output.delta = false;
+        }
+        else if (cmd.word == "FULL")
+        {
+            output.forceFull = true;
+        }
+        else
+        {
+            send_error("Invalid delta mode");
+            return false;
+        }
+        break;
+    case 'T':
+        if (!rm.advanceClock(cmd.count))
+        {
+            send_error("Clock is not VIRTUAL");
+            return false;
+        }
+        break;
+    case 'X': // 'X' for eXamine (just send state)
+        break;
+    case 'C': // 'C' for reCovery
+    {
+        unique_lock<StateGate> guard = rm.lockState();
+        if (rm.strategy == DeadlockStrategy::DETECT)
+            rm.recoveryAgent.initiateRecovery(rm);
+        else
+            rm.log(LogEvent::RECOVERY_DETECT_ONLY);
+        break;
+    }
+    default:
+        send_error("Unknown command type: " + string(1, cmd.type));
+        break;
+    }
+    return true;
 }
 
-int main()
+// Applies a batch of P/R/M/E/X lines as one unit: if any line is malformed
+// nothing is applied. X is deferred: it sets 'examine' so the caller emits
+// once at B END, as binary batches do. Returns false on rejection.
+bool executeBatch(ResourceManager &rm, const vector<string> &lines, StateOutput &output, bool &examine)
 {
-    ResourceManager rm;
-    string line;
+    vector<Command> commands;
+    commands.reserve(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        Command cmd;
+        string error;
+        if (!parseCommand(lines[i], cmd, error))
+        {
+            send_error("Batch rejected (line " + to_string(i + 1) + "): " + error);
+            return false;
+        }
+        if (cmd.type != 'P' && cmd.type != 'R' && cmd.type != 'M' && cmd.type != 'E' && cmd.type != 'X')
+        {
+            send_error("Batch rejected (line " + to_string(i + 1) + "): only P/R/M/E/X allowed");
+            return false;
+        }
+        commands.push_back(cmd);
+    }
+    examine = false;
+    for (const auto &cmd : commands)
+    {
+        if (cmd.type == 'X')
+            examine = true;
+        else
+            executeCommand(rm, cmd, output);
+    }
+    return true;
+}
 
-    // Set output to unbuffered.
-    setvbuf(stdout, NULL, _IONBF, 0);
+// Translates a binary record into a Command (see BinaryProtocol.h).
+// Returns false for an unknown sub-code.
+bool translateBinaryCommand(const BinaryCommand &in, Command &cmd)
+{
+    static const char *const strategies[] = {"DETECT", "AVOID"};
+    static const char *const actions[] = {"REQUEST", "RELEASE", "REQUEST"};
+    static const char *const deltaModes[] = {"OFF", "ON", "FULL"};
+    static const char *const optionNames[] = {"SAFETY", "LOG", "EMIT", "DETECTION", "DETECTION_PERIOD", "DETECTION_WAITS", "DETECTION_THREADS", "DETECTOR", "VICTIM_COST", "PREEMPTION", "MAX_ROLLBACKS", "CLOCK", "AGING_THRESHOLD"};
+    static const vector<vector<string>> optionValues = {
+        {"SWEEP", "INDEXED", "VERIFY"},
+        {"OFF", "SUMMARY", "FULL"},
+        {"AUTO", "MANUAL"},
+        {"INLINE", "BACKGROUND"},
+        {}, // Numeric options: the value is 'a'.
+        {},
+        {},
+        {"GRAPH", "REDUCTION"},
+        {"DEFAULT", "PRIORITY", "HELD", "WAIT", "ROLLBACKS"},
+        {"FULL", "PARTIAL"},
+        {},
+        {"WALL", "MONOTONIC", "VIRTUAL"},
+        {}};
 
-    // Main command loop.
-    while (getline(cin, line))
+    cmd.type = static_cast<char>(in.type);
+    switch (cmd.type)
     {
-        if (line.empty())
-            continue;
+    case 'S':
+        if (in.sub > 1)
+            return false;
+        cmd.word = strategies[in.sub];
+        return true;
+    case 'P':
+        cmd.pId = in.a;
+        return true;
+    case 'R':
+        cmd.rId = in.a;
+        cmd.count = in.b;
+        return true;
+    case 'M':
+    case 'E':
+        if (cmd.type == 'E')
+        {
+            if (in.sub > 2)
+                return false;
+            cmd.word = actions[in.sub];
+            if (in.sub == 2)
+                cmd.parts.emplace_back(in.b, in.c);
+        }
+        cmd.pId = in.a;
+        cmd.rId = in.b;
+        cmd.count = in.c;
+        return true;
+    case 'T':
+        if (in.a <= 0)
+            return false;
+        cmd.count = in.a;
+        return true;
+    case 'D':
+        if (in.sub > 2)
+            return false;
+        cmd.word = deltaModes[in.sub];
+        cmd.count = in.a;
+        return true;
+    case 'O':
+        if (in.sub >= optionValues.size() || in.a < 0)
+            return false;
+        cmd.word = optionNames[in.sub];
+        if (optionValues[in.sub].empty())
+        {
+            cmd.value = to_string(in.a);
+            return true;
+        }
+        if (in.a >= static_cast<int>(optionValues[in.sub].size()))
+            return false;
+        cmd.value = optionValues[in.sub][in.a];
+        return true;
+    default: // X, C, and unknown types (reported when executed).
+        return true;
+    }
+}
 
-        stringstream ss(line);
-        char type;
-        ss >> type;
+// Binary command loop: every frame is applied as a batch, then state is
+// sent once (in manual mode, only if the frame contained an X).
+void runBinaryLoop(ResourceManager &rm, StateOutput &output)
+{
+    setBinaryStdio();
+    vector<BinaryCommand> records;
+    vector<Command> commands, merged;
 
+    while (readBinaryFrame(cin, records))
+    {
         try
         {
-            if (type == 'S')
-            { // Set Strategy
-                string strategyName;
-                ss >> strategyName;
-                if (strategyName == "AVOID")
-                {
-                    rm.setStrategy(DeadlockStrategy::AVOID);
-                }
-                else
+            commands.assign(records.size(), Command());
+            bool valid = true;
+            for (size_t i = 0; i < records.size() && valid; ++i)
+            {
+                if (!translateBinaryCommand(records[i], commands[i]))
                 {
-                    rm.setStrategy(DeadlockStrategy::DETECT);
+                    send_error("Frame rejected (record " + to_string(i + 1) + "): invalid sub-code");
+                    valid = false;
                 }
             }
-            else if (type == 'P')
-            { // Add Process
-                int pId;
-                if (!(ss >> pId))
-                {
-                    send_error("Invalid Process ID");
-                    continue;
-                }
-                rm.addProcess(Process(pId));
+            if (!valid)
+                continue;
+
+            // Consecutive vector parts (E sub 2) for one process are one request.
+            merged.clear();
+            for (size_t i = 0; i < commands.size(); ++i)
+            {
+                bool part = records[i].type == 'E' && records[i].sub == 2;
+                if (part && i > 0 && records[i - 1].type == 'E' && records[i - 1].sub == 2 &&
+                    merged.back().pId == commands[i].pId)
+                    merged.back().parts.push_back(commands[i].parts[0]);
+                else
+                    merged.push_back(commands[i]);
             }
-            else if (type == 'R')
-            { // Add Resource
-                int rId, count;
-                if (!(ss >> rId >> count))
-                {
-                    send_error("Invalid Resource definition");
-                    continue;
-                }
-                rm.addResource(Resource(rId, count));
+
+            bool examine = false;
+            for (const auto &cmd : merged)
+            {
+                executeCommand(rm, cmd, output);
+                examine = examine || cmd.type == 'X';
             }
-            else if (type == 'M')
-            { // Declare Max Need
-                int pId, rId, count;
-                if (!(ss >> pId >> rId >> count))
+            if (!output.manual || examine)
+                emitState(rm, output);
+        }
+        catch (const exception &e)
+        {
+            send_error("C++ Exception: " + string(e.what()));
+        }
+        catch (...)
+        {
+            send_error("Unknown C++ exception.");
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ResourceManager rm;
+    StateOutput output;
+    string line;
+
+    // Output is buffered and flushed once per state emission.
+    ios::sync_with_stdio(false);
+    cin.tie(nullptr);
+
+    // "--binary": length-prefixed binary frames instead of text/JSON.
+    for (int i = 1; i < argc; ++i)
+    {
+        if (string(argv[i]) == "--binary")
+            binaryProtocol = true;
+    }
+    if (binaryProtocol)
+    {
+        runBinaryLoop(rm, output);
+        return 0;
+    }
+
+    // Batch mode ("B BEGIN" ... "B END").
+    bool inBatch = false;
+    vector<string> batch;
+
+    // Main command loop.
+    while (getline(cin, line))
+    {
+        if (line.empty())
+            continue;
+
+        try
+        {
+            stringstream ss(line);
+            char type = 0;
+            string mode;
+            ss >> type >> mode;
+            if (type == 'B')
+            { // Batch control: B BEGIN | B END | B ABORT
+                if (mode == "BEGIN" && !inBatch)
                 {
-                    send_error("Invalid Max Need definition");
-                    continue;
+                    inBatch = true;
+                    batch.clear();
                 }
-                rm.declareMaxResources(pId, rId, count);
-            }
-            else if (type == 'E')
-            { // Execute Event
-                int pId, rId, count;
-                string action;
-                if (!(ss >> pId >> action >> rId >> count))
+                else if (mode == "END" && inBatch)
                 {
-                    send_error("Invalid Event definition");
-                    continue;
+                    inBatch = false;
+                    bool examine = false;
+                    if (executeBatch(rm, batch, output, examine) && (!output.manual || examine))
+                        emitState(rm, output);
+                    batch.clear();
                 }
-                if (action == "REQUEST")
-                    rm.requestResource(pId, rId, count);
-                else if (action == "RELEASE")
-                    rm.releaseResource(pId, rId, count);
-            }
-            else if (type == 'X')
-            {   // 'X' for eXamine (just send state)
-                // Do nothing, state is sent below.
-            }
-            else if (type == 'C')
-            { // 'C' for reCovery
-                if (rm.strategy == DeadlockStrategy::DETECT)
+                else if (mode == "ABORT" && inBatch)
                 {
-                    rm.recoveryAgent.initiateRecovery(rm);
+                    inBatch = false;
+                    batch.clear();
                 }
                 else
                 {
-                    rm.log("Recovery only available in DETECT mode.");
+                    send_error("Invalid batch command");
                 }
+                continue;
             }
-            else
+            if (inBatch)
             {
-                send_error("Unknown command type: " + string(1, type));
+                batch.push_back(line);
+                continue;
             }
 
-            // After EVERY command, send the complete system state back to Python.
-            printStateAsJson(rm);
+            Command cmd;
+            string error;
+            if (!parseCommand(line, cmd, error))
+            {
+                send_error(error);
+                continue;
+            }
+            if (!executeCommand(rm, cmd, output))
+                continue;
+
+            // After every command, send the system state back to Python
+            // (in manual mode, only when asked with X).
+            if (!output.manual || cmd.type == 'X')
+                emitState(rm, output);
         }
         catch (const exception &e)
         {
@@ -257,4 +878,4 @@ int main()
         }
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,50 @@
+#include "../include/AllocationMatrices.h"
+
+using namespace std;
+
+// Append a zeroed row.
+void AllocationMatrices::addRow()
+{
+    allocation.resize(allocation.size() + cols, 0);
+    maxClaim.resize(maxClaim.size() + cols, 0);
+    need.resize(need.size() + cols, 0);
+    request.resize(request.size() + cols, 0);
+    rows++;
+}
+
+// Append a zeroed column (re-lays out every row).
+void AllocationMatrices::addColumn()
+{
+    int newCols = cols + 1;
+    auto widen = [&](vector<int> &matrix)
+    {
+        vector<int> wider(rows * newCols, 0);
+        for (int i = 0; i < rows; ++i)
+        {
+            for (int j = 0; j < cols; ++j)
+                wider[i * newCols + j] = matrix[i * cols + j];
+        }
+        matrix.swap(wider);
+    };
+    widen(allocation);
+    widen(maxClaim);
+    widen(need);
+    widen(request);
+    cols = newCols;
+}
+
+// Change allocation by delta.
+void AllocationMatrices::addAllocation(int row, int col, int delta)
+{
+    int k = index(row, col);
+    allocation[k] += delta;
+    need[k] -= delta;
+}
+
+// Set max claim.
+void AllocationMatrices::setMaxClaim(int row, int col, int maxCount)
+{
+    int k = index(row, col);
+    maxClaim[k] = maxCount;
+    need[k] = maxCount - allocation[k];
+}
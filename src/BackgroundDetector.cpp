@@ -0,0 +1,118 @@
+#include "../include/BackgroundDetector.h"
+#include "../include/ResourceManager.h"
+#include <chrono>
+#include <algorithm>
+
+using namespace std;
+
+// Start the detection thread.
+void BackgroundDetector::start(ResourceManager &rm)
+{
+    if (running)
+        return;
+    rm.setConcurrent(true);
+    rm.waitForGraph.timed = true;
+    stopping = false;
+    newWaits = 0;
+    running = true;
+    worker = thread(&BackgroundDetector::run, this, ref(rm));
+}
+
+// Stop and join (must not be called with the state lock held).
+void BackgroundDetector::stop()
+{
+    if (!running)
+        return;
+    {
+        lock_guard<mutex> lock(wakeLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+    running = false;
+}
+
+// Change triggers; with both disabled, run after every wait.
+void BackgroundDetector::configure(int period, int waits)
+{
+    {
+        lock_guard<mutex> lock(wakeLock);
+        periodMs = period > 0 ? period : 0;
+        waitTrigger = waits > 0 ? waits : 0;
+        if (periodMs == 0 && waitTrigger == 0)
+            waitTrigger = 1;
+        reconfigured = true;
+    }
+    wake.notify_all();
+}
+
+// Count a new wait; wake the thread once enough have piled up.
+void BackgroundDetector::noteWait()
+{
+    lock_guard<mutex> lock(wakeLock);
+    newWaits++;
+    if (waitTrigger > 0 && newWaits >= waitTrigger)
+        wake.notify_all();
+}
+
+// Thread body: sleep until the period elapses or the wait trigger fires.
+void BackgroundDetector::run(ResourceManager &rm)
+{
+    unique_lock<mutex> lock(wakeLock);
+    auto triggered = [this]
+    {
+        return stopping || reconfigured || (waitTrigger > 0 && newWaits >= waitTrigger);
+    };
+
+    while (!stopping)
+    {
+        if (periodMs > 0)
+            wake.wait_for(lock, chrono::milliseconds(periodMs), triggered);
+        else
+            wake.wait(lock, triggered);
+
+        if (stopping)
+            break;
+        if (reconfigured)
+        { // Restart the wait with the new settings.
+            reconfigured = false;
+            continue;
+        }
+
+        newWaits = 0;
+        lock.unlock();
+        detect(rm);
+        lock.lock();
+    }
+}
+
+// One pass: recover until no cycle is left (each recovery removes one victim).
+void BackgroundDetector::detect(ResourceManager &rm)
+{
+    unique_lock<StateGate> guard = rm.lockState();
+    runs++;
+    if (rm.strategy != DeadlockStrategy::DETECT)
+        return;
+
+    size_t rounds = 0;
+    while (rounds++ < rm.processes.size() && rm.detector.hasDeadlock(rm))
+    {
+        deadlocksDetected++;
+        long long formedAt = rm.detector.detectionEngine == DetectionEngine::GRAPH ? rm.waitForGraph.cycleFormedAt() : 0;
+        long long latency = 0;
+        if (formedAt > 0)
+        { // Unstamped (reduction engine, or waiting since before the thread started): no sample.
+            long long now = chrono::duration_cast<chrono::nanoseconds>(
+                                chrono::steady_clock::now().time_since_epoch())
+                                .count();
+            latency = (now - formedAt) / 1000;
+            lastLatencyUs = latency;
+            maxLatencyUs = max(maxLatencyUs, latency);
+            totalLatencyUs += latency;
+            latencySamples++;
+        }
+        rm.log(LogEvent::DEADLOCK_FOUND_BACKGROUND, static_cast<int>(min(latency, 2147483647LL)));
+        if (!rm.recoverFromDeadlock(rounds > 1)) // Re-formed: preempt fully (see resolveDeadlocks).
+            break;
+    }
+}
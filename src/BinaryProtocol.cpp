@@ -0,0 +1,257 @@
+#include "../include/BinaryProtocol.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <cstdio>
+#endif
+
+using namespace std;
+
+// Output payload, reused between frames.
+static vector<unsigned char> payload;
+
+static void putU8(uint8_t v)
+{
+    payload.push_back(v);
+}
+
+static void putU32(uint32_t v)
+{
+    for (int i = 0; i < 4; ++i)
+        payload.push_back((v >> (8 * i)) & 0xFF);
+}
+
+static void putI32(int32_t v)
+{
+    putU32(static_cast<uint32_t>(v));
+}
+
+static void putI64(int64_t v)
+{
+    uint64_t u = static_cast<uint64_t>(v);
+    for (int i = 0; i < 8; ++i)
+        payload.push_back((u >> (8 * i)) & 0xFF);
+}
+
+// Patch a u32 written earlier (for counts known only afterwards).
+static void patchU32(size_t at, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i)
+        payload[at + i] = (v >> (8 * i)) & 0xFF;
+}
+
+static uint32_t getU32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Length prefix + payload, in one write.
+static void sendPayload(ostream &out)
+{
+    unsigned char length[4];
+    uint32_t n = payload.size();
+    for (int i = 0; i < 4; ++i)
+        length[i] = (n >> (8 * i)) & 0xFF;
+    out.write(reinterpret_cast<const char *>(length), 4);
+    out.write(reinterpret_cast<const char *>(payload.data()), payload.size());
+}
+
+// Read one frame of command records.
+bool readBinaryFrame(istream &in, vector<BinaryCommand> &commands)
+{
+    unsigned char header[4];
+    if (!in.read(reinterpret_cast<char *>(header), 4))
+        return false;
+
+    uint32_t length = getU32(header);
+    if (length > BINARY_MAX_FRAME || length % BINARY_COMMAND_SIZE != 0)
+        return false;
+
+    static vector<unsigned char> buffer;
+    buffer.resize(length);
+    if (length > 0 && !in.read(reinterpret_cast<char *>(buffer.data()), length))
+        return false;
+
+    commands.clear();
+    for (uint32_t at = 0; at < length; at += BINARY_COMMAND_SIZE)
+    {
+        const unsigned char *p = &buffer[at];
+        BinaryCommand cmd;
+        cmd.type = p[0];
+        cmd.sub = p[1];
+        cmd.a = static_cast<int32_t>(getU32(p + 4));
+        cmd.b = static_cast<int32_t>(getU32(p + 8));
+        cmd.c = static_cast<int32_t>(getU32(p + 12));
+        commands.push_back(cmd);
+    }
+    return true;
+}
+
+// Resource record.
+static void putResource(const Resource &r)
+{
+    putI32(r.id);
+    putI32(r.totalInstances);
+    putI32(r.availableInstances);
+}
+
+// Process record.
+static void putProcess(const Process &p)
+{
+    putI32(p.id);
+    putI32(p.priority);
+    putU32(p.resourcesHeld.size());
+    for (const auto &pair : p.resourcesHeld)
+    {
+        putI32(pair.first);
+        putI32(pair.second);
+    }
+    putU32(p.maxResourcesNeeded.size());
+    for (const auto &pair : p.maxResourcesNeeded)
+    {
+        putI32(pair.first);
+        putI32(pair.second);
+    }
+    putU32(p.checkpoint.size());
+    for (const auto &pair : p.checkpoint)
+    {
+        putI32(pair.first);
+        putI32(pair.second);
+    }
+}
+
+// Wait queue record.
+static void putWaitQueue(int resourceId, const WaitQueue *waiters)
+{
+    putI32(resourceId);
+    putU32(waiters ? waiters->size() : 0);
+    if (!waiters)
+        return;
+    for (const auto &info : *waiters)
+    {
+        putI32(info.processId);
+        putI32(info.count);
+    }
+}
+
+// State frame.
+void writeBinaryState(ostream &out, ResourceManager &rm, bool full, uint32_t seq)
+{
+    vector<int> deadlocked;
+    if (rm.strategy == DeadlockStrategy::DETECT)
+        deadlocked = rm.detector.deadlockedProcesses(rm);
+
+    payload.clear();
+    putU8(static_cast<uint8_t>(full ? BinaryFrameKind::FULL : BinaryFrameKind::DELTA));
+    putU8(deadlocked.empty() ? 0 : 1);
+    putU8(0);
+    putU8(0);
+    putU32(seq);
+
+    // Resources
+    if (full)
+    {
+        putU32(rm.resources.size());
+        for (const auto &r : rm.resources)
+            putResource(r);
+    }
+    else
+    {
+        putU32(rm.changes.changedResources().size());
+        for (int slot : rm.changes.changedResources())
+            putResource(rm.resources[slot]);
+    }
+
+    // Processes
+    if (full)
+    {
+        putU32(rm.processes.size());
+        for (const auto &p : rm.processes)
+            putProcess(p);
+    }
+    else
+    {
+        putU32(rm.changes.changedProcesses().size());
+        for (int slot : rm.changes.changedProcesses())
+            putProcess(rm.processes[slot]);
+    }
+
+    // Wait queues
+    size_t queueCountAt = payload.size();
+    putU32(0);
+    uint32_t queueCount = 0;
+    if (full)
+    {
+        for (const auto &pair : rm.waitingProcesses)
+        {
+            if (pair.second.empty())
+                continue;
+            putWaitQueue(pair.first, &pair.second);
+            queueCount++;
+        }
+    }
+    else
+    {
+        for (int slot : rm.changes.changedWaitQueues())
+        {
+            int resourceId = rm.resources[slot].id;
+            auto it = rm.waitingProcesses.find(resourceId);
+            putWaitQueue(resourceId, it != rm.waitingProcesses.end() ? &it->second : nullptr);
+            queueCount++;
+        }
+    }
+    patchU32(queueCountAt, queueCount);
+
+    // Deadlocked processes
+    putU32(deadlocked.size());
+    for (int id : deadlocked)
+        putI32(id);
+
+    // Metrics
+    const BackgroundDetector &bg = rm.backgroundDetector;
+    putU32(7);
+    putI64(rm.detector.safetyCacheHits);
+    putI64(rm.detector.safetyCacheMisses);
+    putI64(bg.runs);
+    putI64(bg.deadlocksDetected);
+    putI64(bg.lastLatencyUs);
+    putI64(bg.maxLatencyUs);
+    putI64(bg.averageLatencyUs());
+
+    // Log
+    vector<string> lines = rm.events.formatAll();
+    rm.events.clear();
+    putU32(lines.size());
+    for (const auto &line : lines)
+    {
+        putU32(line.size());
+        payload.insert(payload.end(), line.begin(), line.end());
+    }
+
+    sendPayload(out);
+}
+
+// Error frame.
+void writeBinaryError(ostream &out, const string &message)
+{
+    payload.clear();
+    putU8(static_cast<uint8_t>(BinaryFrameKind::ERROR));
+    putU8(0);
+    putU8(0);
+    putU8(0);
+    putU32(0);
+    putU32(message.size());
+    payload.insert(payload.end(), message.begin(), message.end());
+    sendPayload(out);
+    out.flush();
+}
+
+// Binary stdio.
+void setBinaryStdio()
+{
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+}
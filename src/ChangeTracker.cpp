@@ -0,0 +1,35 @@
+#include "../include/ChangeTracker.h"
+
+using namespace std;
+
+// Flag a slot once.
+void ChangeTracker::mark(deque<atomic<char>> &flags, vector<int> &changed, int slot)
+{
+    if (slot < (int)flags.size() && flags[slot].load(memory_order_relaxed))
+        return;
+
+    unique_lock<mutex> guard(markLock, defer_lock);
+    if (synchronized)
+        guard.lock();
+    while (slot >= (int)flags.size())
+        flags.emplace_back(0);
+    if (!flags[slot])
+    {
+        flags[slot] = 1;
+        changed.push_back(slot);
+    }
+}
+
+// Forget all changes.
+void ChangeTracker::clear()
+{
+    for (int slot : processes)
+        processFlags[slot] = 0;
+    for (int slot : resources)
+        resourceFlags[slot] = 0;
+    for (int slot : queues)
+        queueFlags[slot] = 0;
+    processes.clear();
+    resources.clear();
+    queues.clear();
+}
@@ -1,153 +1,265 @@
 #include "../include/DeadlockDetector.h"
 #include "../include/ResourceManager.h"
+#include "../include/VectorKernels.h"
 #include <iostream>
 #include <vector>
-#include <numeric>
-#include <map>
+#include <string>
+#include <algorithm>
 
 using namespace std;
 
-// Helper: DFS for cycle detection.
-bool dfs_cycle_check(int u, const vector<vector<int>> &adj, vector<int> &visited, vector<int> &recursionStack)
+// GRAPH: check the live wait-for graph for cycles (maintained
+// incrementally by ResourceManager). REDUCTION: full reduction.
+// Queued request vectors add edges for parts that may fit, so a GRAPH
+// cycle is then only a candidate and reduction has the final say.
+bool DeadlockDetector::hasDeadlock(ResourceManager &rm)
 {
-    visited[u] = 1;
-    recursionStack[u] = 1;
-
-    for (int v : adj[u])
+    if (detectionEngine == DetectionEngine::GRAPH)
     {
-        if (!visited[v])
-        {
-            if (dfs_cycle_check(v, adj, visited, recursionStack))
-                return true;
-        }
-        else if (recursionStack[v])
-        {
-            return true; // Cycle.
-        }
+        if (!rm.waitForGraph.hasCycle())
+            return false;
+        if (!rm.hasQueuedVectors())
+            return true;
     }
-    recursionStack[u] = 0; // Backtrack.
-    return false;
+    reduce(rm);
+    return !unreduced.empty();
 }
 
-// Build wait-for graph and check for cycles.
-bool DeadlockDetector::hasCycle(ResourceManager &rm)
+// Coffman/Holt graph reduction.
+//
+// A process holding nothing cannot block anyone, so it is reduced up
+// front. Otherwise a process whose outstanding Request fits in Work can
+// finish and return its Allocation. What never fits is deadlocked. With
+// counted resources this is exact, where a wait-for cycle may not be
+// (another holder outside the cycle can still release).
+void DeadlockDetector::reduce(ResourceManager &rm, const vector<char> *rolledBack)
 {
-    if (rm.processes.empty())
-        return false;
+    const AllocationMatrices &mx = rm.matrices;
+    int n = mx.rows;
+    int m = mx.cols;
+    work.resize(m);
+    for (int j = 0; j < m; ++j)
+        work[j] = rm.resources[j].availableInstances;
 
-    int maxProcessId = 0;
-    for (const auto &p : rm.processes)
+    unreduced.clear();
+    for (int i = 0; i < n; ++i)
     {
-        if (p.id > maxProcessId)
-            maxProcessId = p.id;
+        if (rolledBack && (*rolledBack)[i])
+            rowAccumulate(work.data(), &mx.allocation[i * m], m);
+        else if (!rm.processes[i].resourcesHeld.empty())
+            unreduced.push_back(i);
     }
 
-    vector<vector<int>> adj(maxProcessId + 1);
-    vector<bool> processExists(maxProcessId + 1, false);
-    for (const auto &p : rm.processes)
-        processExists[p.id] = true;
-
-    // Build graph (waiter -> holder).
-    for (const auto &pair : rm.waitingProcesses)
+    // Each pass keeps only what still does not fit.
+    bool progress = true;
+    while (progress && !unreduced.empty())
     {
-        int resourceId = pair.first;
-        vector<int> holders;
-        for (const auto &p : rm.processes)
+        progress = false;
+        size_t keep = 0;
+        for (size_t t = 0; t < unreduced.size(); ++t)
         {
-            if (p.resourcesHeld.count(resourceId) && p.resourcesHeld.at(resourceId) > 0)
+            int i = unreduced[t];
+            if (rowFits(&mx.request[i * m], work.data(), m))
             {
-                holders.push_back(p.id);
+                rowAccumulate(work.data(), &mx.allocation[i * m], m);
+                progress = true;
             }
-        }
-        for (const auto &waitingInfo : pair.second)
-        {
-            int waiterId = waitingInfo.processId;
-            if (waiterId >= 0 && waiterId <= maxProcessId)
+            else
             {
-                for (int holderId : holders)
-                {
-                    if (holderId >= 0 && holderId <= maxProcessId)
-                    {
-                        adj[waiterId].push_back(holderId);
-                    }
-                }
+                unreduced[keep++] = i;
             }
         }
+        unreduced.resize(keep);
     }
+}
 
-    // Run DFS.
-    vector<int> visited(maxProcessId + 1, 0);
-    vector<int> recursionStack(maxProcessId + 1, 0);
-    for (int i = 0; i <= maxProcessId; ++i)
+// Full component search over the wait-for graph.
+vector<vector<int>> DeadlockDetector::findDeadlocks(ResourceManager &rm)
+{
+    if (detectionEngine == DetectionEngine::GRAPH && !rm.hasQueuedVectors())
+        return rm.waitForGraph.deadlockedComponents(pool.get());
+
+    vector<vector<int>> deadlocks;
+    reduce(rm);
+    if (unreduced.empty())
+        return deadlocks;
+    vector<int> ids;
+    for (int slot : unreduced)
+        ids.push_back(rm.processes[slot].id);
+    sort(ids.begin(), ids.end());
+    deadlocks.push_back(ids);
+    return deadlocks;
+}
+
+// GRAPH: a victim's edges all go, and no new cycle can form, so only the
+// subgraph of the remaining members needs searching. REDUCTION (and GRAPH
+// with vectors queued, as in findDeadlocks): rerun the reduction with the
+// victims' holdings returned up front.
+vector<vector<int>> DeadlockDetector::findDeadlocksWithout(ResourceManager &rm, const unordered_set<int> &victims,
+                                                           const vector<vector<int>> &deadlocks)
+{
+    if (detectionEngine == DetectionEngine::GRAPH && !rm.hasQueuedVectors())
     {
-        if (processExists[i] && !visited[i])
+        vector<int> members;
+        for (const auto &component : deadlocks)
         {
-            if (dfs_cycle_check(i, adj, visited, recursionStack))
-                return true;
+            for (int id : component)
+            {
+                if (!victims.count(id))
+                    members.push_back(id);
+            }
         }
+        return rm.waitForGraph.deadlockedComponentsAmong(members);
     }
-    return false;
+
+    vector<char> rolledBack(rm.matrices.rows, 0);
+    for (int i = 0; i < rm.matrices.rows; ++i)
+        rolledBack[i] = victims.count(rm.processes[i].id) ? 1 : 0;
+    vector<vector<int>> remaining;
+    reduce(rm, &rolledBack);
+    if (unreduced.empty())
+        return remaining;
+    vector<int> ids;
+    for (int slot : unreduced)
+        ids.push_back(rm.processes[slot].id);
+    sort(ids.begin(), ids.end());
+    remaining.push_back(ids);
+    return remaining;
+}
+
+// The caller takes part in the search, so n threads = n - 1 workers.
+void DeadlockDetector::setDetectionThreads(int threads)
+{
+    if (threads == getDetectionThreads())
+        return;
+    pool.reset(threads > 1 ? new ThreadPool(threads - 1) : nullptr);
+}
+
+// Processes to report as deadlocked.
+vector<int> DeadlockDetector::deadlockedProcesses(ResourceManager &rm)
+{
+    vector<int> ids;
+    if (detectionEngine == DetectionEngine::GRAPH && !hasDeadlock(rm))
+        return ids; // Cheap incremental check first.
+    for (const auto &component : findDeadlocks(rm))
+        ids.insert(ids.end(), component.begin(), component.end());
+    sort(ids.begin(), ids.end());
+    return ids;
 }
 
 // Banker's Algorithm: Check if state is safe.
+// Reads the persistent matrices in ResourceManager; scratch space is reused.
 bool DeadlockDetector::isSafeState(ResourceManager &rm)
 {
-    int n = rm.processes.size();
-    int m = rm.resources.size();
+    const AllocationMatrices &mx = rm.matrices;
+    int n = mx.rows;
+    int m = mx.cols;
     if (n == 0)
         return true;
 
-    // --- Setup Matrices ---
-    vector<int> available(m);
-    map<int, int> resourceIdToIndex;
-    for (int i = 0; i < m; ++i)
+    // Need = Max - Allocation must not be negative.
+    for (int k = 0; k < n * m; ++k)
     {
-        available[i] = rm.resources[i].availableInstances;
-        resourceIdToIndex[rm.resources[i].id] = i;
+        if (mx.need[k] < 0)
+        {
+            rm.log(LogEvent::ALLOC_EXCEEDS_MAX, rm.processes[k / m].id);
+            return false;
+        }
     }
 
-    vector<vector<int>> max_need(n, vector<int>(m, 0));
-    vector<vector<int>> allocation(n, vector<int>(m, 0));
-    vector<vector<int>> need(n, vector<int>(m, 0));
+    bool safe = runSafety(safetyEngine, mx, rm);
+    if (verifySafetyEngines)
+    {
+        SafetyEngine other = (safetyEngine == SafetyEngine::SWEEP) ? SafetyEngine::INDEXED : SafetyEngine::SWEEP;
+        vector<int> sequence = safeSequence;
+        if (runSafety(other, mx, rm) != safe)
+            rm.log(LogEvent::SAFETY_DISAGREE);
+        safeSequence.swap(sequence);
+    }
 
-    map<int, int> processIdToIndex;
-    for (int i = 0; i < n; ++i)
+    if (!safe)
     {
-        processIdToIndex[rm.processes[i].id] = i;
-        for (const auto &pair : rm.processes[i].maxResourcesNeeded)
-        {
-            if (resourceIdToIndex.count(pair.first))
-            {
-                max_need[i][resourceIdToIndex[pair.first]] = pair.second;
-            }
-        }
-        for (const auto &pair : rm.processes[i].resourcesHeld)
-        {
-            if (resourceIdToIndex.count(pair.first))
-            {
-                allocation[i][resourceIdToIndex[pair.first]] = pair.second;
-            }
-        }
+        rm.log(LogEvent::NOT_SAFE);
+        return false;
     }
 
-    // Calculate Need = Max - Allocation
-    for (int i = 0; i < n; ++i)
+    // State is safe; remember the sequence.
+    cachedSequence = safeSequence;
+    cachedPosition.assign(n, -1);
+    for (size_t i = 0; i < cachedSequence.size(); ++i)
+        cachedPosition[cachedSequence[i]] = i;
+    cacheValid = true;
+
+    // Sequence is logged as one SAFE record plus one item per process.
+    if (EventLog::levelOf(LogEvent::SAFE) <= rm.events.level)
     {
-        for (int j = 0; j < m; ++j)
+        rm.log(LogEvent::SAFE, safeSequence.size());
+        for (int slot : safeSequence)
+            rm.log(LogEvent::SEQUENCE_ITEM, rm.processes[slot].id);
+    }
+    return true;
+}
+
+// Safety check after a tentative grant, using the cached sequence if possible.
+//
+// Granting 'count' of column 'col' to row 'row' only lowers Work[col] for
+// the processes ahead of 'row' in the cached sequence; from 'row' onwards
+// Work is unchanged (it gets the instances back on completion). So the old
+// sequence stays valid iff that prefix still fits in column 'col'.
+// (Releases only raise Work, so they never invalidate the sequence.)
+bool DeadlockDetector::isSafeAfterGrant(ResourceManager &rm, int row, int col, int count)
+{
+    const AllocationMatrices &mx = rm.matrices;
+    int m = mx.cols;
+    if (cacheValid && count > 0 && row < (int)cachedPosition.size() && cachedPosition[row] >= 0 && mx.need[row * m + col] >= 0)
+    {
+        int end = cachedPosition[row];
+        int w = rm.resources[col].availableInstances;
+        bool fits = true;
+        for (int t = 0; t < end; ++t)
         {
-            need[i][j] = max_need[i][j] - allocation[i][j];
-            if (need[i][j] < 0)
+            int k = cachedSequence[t] * m + col;
+            if (mx.need[k] > w)
             {
-                rm.log("Error: P" + to_string(rm.processes[i].id) + " alloc > max need.");
-                return false;
+                fits = false;
+                break;
             }
+            w += mx.allocation[k];
+        }
+        if (fits)
+        {
+            safetyCacheHits++;
+            rm.log(LogEvent::SAFE_CACHED);
+            return true;
         }
     }
 
-    // --- Safety Algorithm ---
-    vector<bool> finish(n, false);
-    vector<int> work = available;
-    vector<int> safeSequence;
+    // Miss: full check. An unsafe verdict leaves the cache alone, since
+    // the caller rolls the grant back to the state the cache describes.
+    safetyCacheMisses++;
+    return isSafeState(rm);
+}
+
+// Run the selected engine from Work = Available.
+bool DeadlockDetector::runSafety(SafetyEngine engine, const AllocationMatrices &mx, ResourceManager &rm)
+{
+    int m = mx.cols;
+    work.resize(m);
+    for (int j = 0; j < m; ++j)
+        work[j] = rm.resources[j].availableInstances;
+    safeSequence.clear();
+
+    if (engine == SafetyEngine::INDEXED)
+        return indexedSafety(mx);
+    return sweepSafety(mx);
+}
+
+// Classic sweep: repeat passes until every process finishes or none can.
+bool DeadlockDetector::sweepSafety(const AllocationMatrices &mx)
+{
+    int n = mx.rows;
+    int m = mx.cols;
+    finish.assign(n, 0);
     int finishedCount = 0;
 
     while (finishedCount < n)
@@ -157,43 +269,82 @@ bool DeadlockDetector::isSafeState(ResourceManager &rm)
         {
             if (!finish[i])
             {
-                // Check if Need <= Work.
-                bool canSatisfyNeed = true;
-                for (int j = 0; j < m; ++j)
+                // If Need <= Work, simulate completion.
+                if (rowFits(&mx.need[i * m], work.data(), m))
                 {
-                    if (need[i][j] > work[j])
-                    {
-                        canSatisfyNeed = false;
-                        break;
-                    }
-                }
-                // If yes, simulate completion.
-                if (canSatisfyNeed)
-                {
-                    for (int j = 0; j < m; ++j)
-                        work[j] += allocation[i][j];
-                    finish[i] = true;
-                    safeSequence.push_back(rm.processes[i].id);
+                    rowAccumulate(work.data(), &mx.allocation[i * m], m);
+                    finish[i] = 1;
+                    safeSequence.push_back(i);
                     finishedCount++;
                     foundProcess = true;
                 }
             }
         }
         if (!foundProcess)
-        {
-            rm.log("Banker's: System is NOT SAFE.");
             return false;
+    }
+    return true;
+}
+
+// Indexed search: each process counts the resources still blocking it.
+// When Work[j] grows, only the queue for j is advanced, so a process is
+// revisited only when one of its blocking resources becomes satisfiable.
+bool DeadlockDetector::indexedSafety(const AllocationMatrices &mx)
+{
+    int n = mx.rows;
+    int m = mx.cols;
+
+    blockedCount.assign(n, 0);
+    if ((int)needQueues.size() < m)
+        needQueues.resize(m);
+    queueHeads.assign(m, 0);
+    ready.clear();
+
+    for (int j = 0; j < m; ++j)
+        needQueues[j].clear();
+    for (int i = 0; i < n; ++i)
+    {
+        const int *need = &mx.need[i * m];
+        for (int j = 0; j < m; ++j)
+        {
+            if (need[j] > work[j])
+            {
+                needQueues[j].emplace_back(need[j], i);
+                blockedCount[i]++;
+            }
         }
+        if (blockedCount[i] == 0)
+            ready.push_back(i);
     }
+    for (int j = 0; j < m; ++j)
+        sort(needQueues[j].begin(), needQueues[j].end());
 
-    // State is safe.
-    string seq_s = "Banker's: System is SAFE. Sequence: ";
-    for (size_t i = 0; i < safeSequence.size(); ++i)
+    // Ready is a stack; reverse so low slots finish first, as in the sweep.
+    reverse(ready.begin(), ready.end());
+
+    while (!ready.empty())
     {
-        seq_s += "P" + to_string(safeSequence[i]);
-        if (i < safeSequence.size() - 1)
-            seq_s += " -> ";
+        int i = ready.back();
+        ready.pop_back();
+        safeSequence.push_back(i);
+
+        const int *allocation = &mx.allocation[i * m];
+        for (int j = 0; j < m; ++j)
+        {
+            if (allocation[j] == 0)
+                continue;
+            work[j] += allocation[j];
+
+            auto &queue = needQueues[j];
+            int &head = queueHeads[j];
+            while (head < (int)queue.size() && queue[head].first <= work[j])
+            {
+                int waiter = queue[head].second;
+                if (--blockedCount[waiter] == 0)
+                    ready.push_back(waiter);
+                head++;
+            }
+        }
     }
-    rm.log(seq_s);
-    return true;
-}
\ No newline at end of file
+    return (int)safeSequence.size() == n;
+}
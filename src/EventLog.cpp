@@ -0,0 +1,282 @@
+#include "../include/EventLog.h"
+
+using namespace std;
+
+// Preallocate the ring.
+EventLog::EventLog(size_t capacity) : ring(capacity) {}
+
+// Append a record, overwriting the oldest when full.
+void EventLog::push(LogEvent event, int a, int b, int c, int d)
+{
+    if (level == LogLevel::SUMMARY && levelOf(event) == LogLevel::FULL)
+        return;
+
+    unique_lock<mutex> guard(pushLock, defer_lock);
+    if (synchronized)
+        guard.lock();
+
+    size_t capacity = ring.size();
+    if (capacity == 0)
+        return;
+    if (count == capacity)
+    {
+        head = (head + 1) % capacity;
+        count--;
+        dropped++;
+    }
+    ring[(head + count) % capacity] = {event, a, b, c, d};
+    count++;
+}
+
+// Detail events only show up at FULL.
+LogLevel EventLog::levelOf(LogEvent event)
+{
+    switch (event)
+    {
+    case LogEvent::MAX_DECLARED:
+    case LogEvent::TENTATIVE_ALLOCATE:
+    case LogEvent::ROLLBACK_UNSAFE:
+    case LogEvent::POST_RECOVERY_CHECK:
+    case LogEvent::CHECK_WAITS:
+    case LogEvent::TENTATIVE_GRANT_WAITER:
+    case LogEvent::WAITER_UNSAFE:
+    case LogEvent::VECTOR_PART:
+    case LogEvent::AGING_CHECK:
+    case LogEvent::NOT_SAFE:
+    case LogEvent::SAFE:
+    case LogEvent::SEQUENCE_ITEM:
+    case LogEvent::SAFE_CACHED:
+    case LogEvent::ANALYZING_VICTIMS:
+    case LogEvent::VICTIM_COST:
+    case LogEvent::VICTIM_INELIGIBLE:
+    case LogEvent::RECOVERY_PLAN:
+    case LogEvent::REMOVING_FROM_WAITS:
+    case LogEvent::AGING_STARTED:
+    case LogEvent::AGING_STOPPED:
+        return LogLevel::FULL;
+    default:
+        return LogLevel::SUMMARY;
+    }
+}
+
+// Fixed-point cost (x1000) as text.
+static string costText(int milli)
+{
+    return to_string(milli / 1000.0);
+}
+
+// Text for one record.
+string EventLog::format(const LogRecord &r)
+{
+    switch (r.event)
+    {
+    case LogEvent::STRATEGY_AVOID:
+        return "[Strategy: Deadlock AVOIDANCE (Banker's Algorithm)]";
+    case LogEvent::STRATEGY_DETECT:
+        return "[Strategy: Deadlock DETECTION & RECOVERY (Graph Cycle)]";
+    case LogEvent::SAFETY_ENGINE:
+        return string("[Safety engine: ") + (r.a == 0 ? "SWEEP" : r.a == 1 ? "INDEXED" : "VERIFY") + "]";
+    case LogEvent::DUPLICATE_PROCESS:
+        return "Warning: P" + to_string(r.a) + " already exists.";
+    case LogEvent::DUPLICATE_RESOURCE:
+        return "Warning: R" + to_string(r.a) + " already exists.";
+    case LogEvent::MAX_CLAMPED:
+        return "Warning: P" + to_string(r.a) + " max (" + to_string(r.b) + ") for R" + to_string(r.c) + " > total (" + to_string(r.d) + "). Clamping.";
+    case LogEvent::MAX_DECLARED:
+        return "  - P" + to_string(r.a) + " declared max R" + to_string(r.b) + ": " + to_string(r.c);
+    case LogEvent::MAX_INVALID:
+        return "Warning: Invalid P/R ID for max declaration.";
+
+    case LogEvent::REQUEST:
+        return "P" + to_string(r.a) + " requests " + to_string(r.b) + " of R" + to_string(r.c);
+    case LogEvent::REQUEST_INVALID_ID:
+        return "Error: Invalid P/R ID in request.";
+    case LogEvent::REQUEST_INVALID_COUNT:
+        return "Error: Request count must be > 0.";
+    case LogEvent::REQUEST_NO_MAX:
+        return "Error: P" + to_string(r.a) + " requested R" + to_string(r.b) + " but has no max need declared.";
+    case LogEvent::REQUEST_EXCEEDS_MAX:
+        return "Error: P" + to_string(r.a) + " request exceeds declared max need.";
+    case LogEvent::REQUEST_VECTOR:
+        return "P" + to_string(r.a) + " requests " + to_string(r.b) + " resource(s), all or nothing:";
+    case LogEvent::VECTOR_PART:
+        return "  - " + to_string(r.a) + " of R" + to_string(r.b);
+    case LogEvent::VECTOR_DUPLICATE:
+        return "Error: R" + to_string(r.a) + " appears twice in the request.";
+    case LogEvent::VECTOR_ALREADY_QUEUED:
+        return "Error: P" + to_string(r.a) + " already has a request vector waiting.";
+    case LogEvent::ALREADY_WAITING:
+        return "Error: P" + to_string(r.a) + " is already waiting on R" + to_string(r.b) + ".";
+    case LogEvent::TENTATIVE_ALLOCATE:
+        return "  - Tentatively allocating for safety check...";
+    case LogEvent::GRANTED_SAFE:
+        return "Request GRANTED (Safe state).";
+    case LogEvent::ROLLBACK_UNSAFE:
+        return "  - Rolling back (Unsafe state).";
+    case LogEvent::DENIED_UNSAFE:
+        return "Request DENIED (Unsafe). P" + to_string(r.a) + " must wait.";
+    case LogEvent::DENIED_MUST_WAIT:
+        return "Request DENIED (Not enough). P" + to_string(r.a) + " must wait.";
+    case LogEvent::GRANTED:
+        return "Request GRANTED.";
+    case LogEvent::DENIED_WAITS:
+        return "Request DENIED (Not enough). P" + to_string(r.a) + " waits.";
+    case LogEvent::POST_RECOVERY_CHECK:
+        return "  - Post-recovery: Checking wait queues.";
+    case LogEvent::RECOVERY_CRITICAL:
+        return "*** CRITICAL: Deadlock detected but RECOVERY FAILED! ***";
+
+    case LogEvent::RELEASE:
+        return "P" + to_string(r.a) + " releases " + to_string(r.b) + " of R" + to_string(r.c);
+    case LogEvent::RELEASE_INVALID_ID:
+        return "Error: Invalid P/R ID in release.";
+    case LogEvent::RELEASE_INVALID_COUNT:
+        return "Error: Release count must be > 0.";
+    case LogEvent::RELEASED:
+        return "R" + to_string(r.a) + " released (Available: " + to_string(r.b) + ").";
+    case LogEvent::RELEASE_TOO_MANY:
+        return "Error: P" + to_string(r.a) + " cannot release " + to_string(r.b) + " of R" + to_string(r.c) + " (Holds: " + to_string(r.d) + ").";
+    case LogEvent::CHECK_WAITS:
+        return "  - Checking waits for R" + to_string(r.a) + " (Available: " + to_string(r.b) + ")";
+    case LogEvent::TENTATIVE_GRANT_WAITER:
+        return "  - Tentatively granting to P" + to_string(r.a) + " (pending safety check)...";
+    case LogEvent::WAITER_GRANTED_SAFE:
+        return "    - Granting " + to_string(r.a) + " of R" + to_string(r.b) + " to P" + to_string(r.c) + " (Safe).";
+    case LogEvent::WAITER_UNSAFE:
+        return "    - Cannot grant to P" + to_string(r.a) + " (unsafe). Rolling back.";
+    case LogEvent::WAITER_GRANTED:
+        return "    - Granting " + to_string(r.a) + " of R" + to_string(r.b) + " to P" + to_string(r.c) + ".";
+    case LogEvent::VECTOR_WAITER_GRANTED:
+        return "    - Granting P" + to_string(r.a) + " its whole request (" + to_string(r.b) + " resource(s)).";
+    case LogEvent::AGING_CHECK:
+        return "--- Applying Aging Check ---";
+
+    case LogEvent::ALLOC_EXCEEDS_MAX:
+        return "Error: P" + to_string(r.a) + " alloc > max need.";
+    case LogEvent::SAFETY_DISAGREE:
+        return "Error: Safety engines disagree on verdict.";
+    case LogEvent::NOT_SAFE:
+        return "Banker's: System is NOT SAFE.";
+    case LogEvent::SAFE:
+        return "Banker's: System is SAFE. Sequence: ";
+    case LogEvent::SEQUENCE_ITEM:
+        return "P" + to_string(r.a);
+    case LogEvent::SAFE_CACHED:
+        return "Banker's: System is SAFE (cached sequence still valid).";
+
+    case LogEvent::DEADLOCK_DETECTED:
+        return "\nDEADLOCK DETECTED! Initiating recovery...";
+    case LogEvent::RECOVERY_NO_MEMBERS:
+        return "*** Recovery FAILED: Cannot identify involved processes. ***";
+    case LogEvent::ANALYZING_VICTIMS:
+        return "  - Analyzing potential victims...";
+    case LogEvent::VICTIM_COST:
+        return "    - P" + to_string(r.a) + " cost: " + costText(r.b);
+    case LogEvent::VICTIM_INELIGIBLE:
+        return "    - P" + to_string(r.a) + " skipped (rolled back " + to_string(r.b) + " times).";
+    case LogEvent::VICTIM_CAP_WAIVED:
+        return "  - Every member is at the rollback cap; choosing P" + to_string(r.a) + " anyway.";
+    case LogEvent::RECOVERY_NO_VICTIM:
+        return "*** Recovery FAILED: Cannot select victim. ***";
+    case LogEvent::RECOVERY_VICTIM_MISSING:
+        return "*** Recovery FAILED: Victim P" + to_string(r.a) + " not found. ***";
+    case LogEvent::RECOVERY_PLAN:
+        return "  - Plan: preempt " + to_string(r.a) + " victim(s).";
+    case LogEvent::VICTIM_SELECTED:
+        return "  - Selected P" + to_string(r.a) + " as victim (Cost: " + costText(r.b) + ").";
+    case LogEvent::NOTHING_PREEMPTED:
+        return "  - P" + to_string(r.a) + " holds nothing the deadlock needs; no preemption.";
+    case LogEvent::PREEMPTING:
+        return "  - Preempting " + to_string(r.a) + " of R" + to_string(r.b) + " from P" + to_string(r.c);
+    case LogEvent::REQUEUED:
+        return "  - Requeued P" + to_string(r.a) + " for " + to_string(r.b) + " of R" + to_string(r.c) + ".";
+    case LogEvent::REMOVING_FROM_WAITS:
+        return "  - Removing P" + to_string(r.a) + " from wait lists.";
+    case LogEvent::RECOVERY_SUCCESS:
+        return "Recovery successful for P" + to_string(r.a) + ".";
+    case LogEvent::RECOVERY_DETECT_ONLY:
+        return "Recovery only available in DETECT mode.";
+    case LogEvent::DETECTION_INLINE:
+        return "[Detection: inline, on every denied request]";
+    case LogEvent::DETECTION_BACKGROUND:
+        return "[Detection: background thread (period " + to_string(r.a) + " ms, after " + to_string(r.b) + " waits)]";
+    case LogEvent::DETECTION_ENGINE:
+        return string("[Detector: ") + (r.a == 0 ? "wait-for graph cycles" : "graph reduction (counted resources)") + "]";
+    case LogEvent::VICTIM_COST_MODEL:
+    {
+        static const char *const models[] = {"held - priority + rollback and wait history", "lowest priority first",
+                                             "fewest instances held", "shortest wait", "fewest rollbacks"};
+        return string("[Victim cost: ") + models[r.a] + "]";
+    }
+    case LogEvent::PREEMPTION_MODE:
+        return string("[Preemption: ") + (r.a ? "partial, lost holdings requeued" : "full") + "]";
+    case LogEvent::ROLLBACK_CAP:
+        if (r.a == 0)
+            return "[Rollback cap: none]";
+        return "[Rollback cap: victims skipped after " + to_string(r.a) + " rollbacks]";
+    case LogEvent::DETECTION_THREADS:
+        return "[Detection: component search on " + to_string(r.a) + " thread(s)]";
+    case LogEvent::DEADLOCK_FOUND_BACKGROUND:
+        return "Background detector found a deadlock (" + to_string(r.a) + " us after it formed).";
+
+    case LogEvent::CLOCK_SOURCE:
+    {
+        static const char *const sources[] = {"wall (seconds)", "monotonic (seconds)", "virtual (ticks)"};
+        return string("[Clock: ") + sources[r.a] + "]";
+    }
+    case LogEvent::CLOCK_ADVANCED:
+        return "Clock advanced " + to_string(r.a) + " tick(s).";
+    case LogEvent::CLOCK_NOT_VIRTUAL:
+        return "Clock can only be advanced in VIRTUAL mode.";
+    case LogEvent::AGING_THRESHOLD:
+        return "[Aging: priority step every " + to_string(r.a) + " clock unit(s)]";
+    case LogEvent::AGING_STARTED:
+        return "  - Aging: P" + to_string(r.a) + " started waiting.";
+    case LogEvent::AGING_BOOST:
+        return "*** Aging: Increased P" + to_string(r.a) + " priority to " + to_string(r.b) + " ***";
+    case LogEvent::AGING_STOPPED:
+        return "  - Aging: P" + to_string(r.a) + " stopped waiting.";
+    }
+    return "";
+}
+
+// Format the buffer. A SAFE record absorbs the SEQUENCE_ITEMs after it.
+vector<string> EventLog::formatAll() const
+{
+    vector<string> lines;
+    if (dropped > 0)
+        lines.push_back("(" + to_string(dropped) + " older log entries dropped)");
+
+    size_t capacity = ring.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        const LogRecord &r = ring[(head + i) % capacity];
+        if (r.event == LogEvent::SEQUENCE_ITEM)
+            continue; // Orphaned by overwrite.
+
+        string line = format(r);
+        if (r.event == LogEvent::SAFE)
+        {
+            for (int k = 0; k < r.a && i + 1 < count; ++k)
+            {
+                const LogRecord &item = ring[(head + i + 1) % capacity];
+                if (item.event != LogEvent::SEQUENCE_ITEM)
+                    break;
+                if (k > 0)
+                    line += " -> ";
+                line += format(item);
+                i++;
+            }
+        }
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// Empty the buffer.
+void EventLog::clear()
+{
+    head = 0;
+    count = 0;
+    dropped = 0;
+}
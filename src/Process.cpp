@@ -3,7 +3,7 @@
 using namespace std;
 
 // Process constructor.
-Process::Process(int processId) : id(processId), priority(0), waitStartTime(0) {}
+Process::Process(int processId) : id(processId), priority(0), waitStartTime(0), waitingSince(0), rollbackCount(0) {}
 
 // Increment priority.
 void Process::increasePriority()
@@ -15,4 +15,5 @@ void Process::increasePriority()
 void Process::resetWaitTime()
 {
     this->waitStartTime = 0;
+    this->waitingSince = 0;
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include <set>
 #include <limits>
 #include <map>
+#include <cmath>
+#include <unordered_set>
 
 using namespace std;
 
@@ -18,106 +20,241 @@ map<int, int> RecoveryAgent::getPreemptedResources()
     return lastVictimPreemptedResources;
 }
 
-// Attempt deadlock recovery.
-bool RecoveryAgent::initiateRecovery(ResourceManager &rm)
+// Switch to a named weighting (drops any custom function). Only DEFAULT
+// blends terms; every other model weighs a single one.
+void RecoveryAgent::setCostModel(VictimCostModel model)
 {
-    rm.log("\nDEADLOCK DETECTED! Initiating recovery...");
-    lastVictimProcess = nullptr;
-    lastVictimPreemptedResources.clear();
+    costModel = model;
+    costFunction = nullptr;
+    costWeights = VictimCostWeights();
+    if (model == VictimCostModel::DEFAULT)
+        return;
+    costWeights = {0, 0, 0, 0, 0};
+    if (model == VictimCostModel::PRIORITY)
+        costWeights.priority = 1;
+    else if (model == VictimCostModel::HELD)
+        costWeights.instancesHeld = 1;
+    else if (model == VictimCostModel::WAIT)
+        costWeights.waitTime = 1;
+    else
+        costWeights.rollbacks = 1;
+}
+
+// Cost of preempting p (lower = better victim).
+double RecoveryAgent::victimCost(ResourceManager &rm, const Process &p)
+{
+    if (costFunction)
+        return costFunction(rm, p);
+
+    double instances = 0;
+    for (const auto &pair : p.resourcesHeld)
+        instances += pair.second;
+    double cost = costWeights.typesHeld * p.resourcesHeld.size() + costWeights.instancesHeld * instances +
+                  costWeights.priority * p.priority + costWeights.rollbacks * p.rollbackCount;
+    if (costWeights.waitTime != 0 && p.waitingSince != 0)
+        cost += costWeights.waitTime * (rm.clock.now() - p.waitingSince);
+    return cost;
+}
 
-    // 1. Identify potential cycle members.
-    set<int> potentialCycleMembers;
-    for (const auto &pair : rm.waitingProcesses)
+// Eligible as a victim under the rollback cap.
+bool RecoveryAgent::isEligible(const Process &p) const
+{
+    return maxRollbacks <= 0 || p.rollbackCount < maxRollbacks;
+}
+
+// Greedy minimum-cost cover. Each round takes the cheapest eligible member
+// of every deadlock still left (the cheapest member if all are capped),
+// then asks the detector what would remain with those victims rolled
+// back. A final pass drops victims (most expensive first) the rest
+// already cover. An exact minimum is a weighted feedback vertex set,
+// which is NP-hard; this keeps one detector pass per round.
+vector<int> RecoveryAgent::planVictims(ResourceManager &rm, const vector<vector<int>> &deadlocks, map<int, double> &costs)
+{
+    vector<int> plan;
+    unordered_set<int> victims;
+    vector<vector<int>> remaining = deadlocks;
+
+    rm.log(LogEvent::ANALYZING_VICTIMS);
+    while (!remaining.empty())
     {
-        for (const auto &waitingInfo : pair.second)
+        for (const auto &component : remaining)
         {
-            potentialCycleMembers.insert(waitingInfo.processId); // Waiter.
-            Resource *res = rm.findResourceById(pair.first);
-            if (res)
-            { // Holders.
-                for (const auto &p : rm.processes)
+            int victimId = -1, cappedId = -1;
+            double minCost = numeric_limits<double>::max(), minCapped = minCost;
+            for (int procId : component)
+            {
+                Process *p = rm.findProcessById(procId);
+                if (!p)
+                    continue;
+                auto known = costs.find(procId);
+                if (known == costs.end())
+                {
+                    known = costs.emplace(procId, victimCost(rm, *p)).first;
+                    rm.log(LogEvent::VICTIM_COST, procId, lround(known->second * 1000));
+                    if (!isEligible(*p))
+                        rm.log(LogEvent::VICTIM_INELIGIBLE, procId, p->rollbackCount);
+                }
+                double &best = isEligible(*p) ? minCost : minCapped;
+                if (known->second < best)
                 {
-                    if (p.resourcesHeld.count(pair.first) && p.resourcesHeld.at(pair.first) > 0)
-                    {
-                        potentialCycleMembers.insert(p.id);
-                    }
+                    best = known->second;
+                    (isEligible(*p) ? victimId : cappedId) = procId;
                 }
             }
+            if (victimId == -1 && cappedId != -1)
+            { // Everyone is capped; the deadlock must still be broken.
+                rm.log(LogEvent::VICTIM_CAP_WAIVED, cappedId);
+                victimId = cappedId;
+            }
+            if (victimId == -1)
+                return vector<int>();
+            victims.insert(victimId);
+            plan.push_back(victimId);
         }
+        remaining = rm.detector.findDeadlocksWithout(rm, victims, deadlocks);
     }
 
-    if (potentialCycleMembers.empty())
+    if (plan.size() > 1)
     {
-        rm.log("*** Recovery FAILED: Cannot identify involved processes. ***");
-        return false;
-    }
-
-    // 2. Select victim with lowest cost.
-    int victimId = -1;
-    double minCost = numeric_limits<double>::max();
-
-    rm.log("  - Analyzing potential victims...");
-    for (int procId : potentialCycleMembers)
-    {
-        Process *p = rm.findProcessById(procId);
-        if (p)
+        vector<int> byCost = plan;
+        stable_sort(byCost.begin(), byCost.end(), [&](int a, int b) { return costs[a] > costs[b]; });
+        for (int id : byCost)
         {
-            // Cost = (types held) + (instances held) - priority.
-            double resourceCost = p->resourcesHeld.size();
-            for (const auto &pair : p->resourcesHeld)
-            {
-                resourceCost += pair.second;
-            }
-            // CHANGED: Fixed typo p.priority to p->priority
-            double cost = resourceCost - p->priority;
-
-            rm.log("    - P" + to_string(p->id) + " cost: " + to_string(cost));
-            if (cost < minCost)
-            {
-                minCost = cost;
-                victimId = p->id;
-            }
+            victims.erase(id);
+            if (!rm.detector.findDeadlocksWithout(rm, victims, deadlocks).empty())
+                victims.insert(id);
         }
+        plan.erase(remove_if(plan.begin(), plan.end(), [&](int id) { return !victims.count(id); }), plan.end());
     }
+    return plan;
+}
 
-    if (victimId == -1)
+// Demand queued up to the last surviving member (waits are served in
+// queue order, so whoever is ahead of a survivor is served first), less
+// what is free. The victim's own waits are about to be dropped.
+int RecoveryAgent::shortfall(ResourceManager &rm, int resourceId, int victimId, const unordered_set<int> &survivors)
+{
+    const auto &waiting = rm.getWaitingProcesses();
+    auto queue = waiting.find(resourceId);
+    Resource *res = rm.findResourceById(resourceId);
+    if (queue == waiting.end() || !res)
+        return 0;
+    int queued = 0, demand = 0;
+    for (const auto &info : queue->second)
     {
-        rm.log("*** Recovery FAILED: Cannot select victim. ***");
-        return false;
+        if (info.processId == victimId)
+            continue;
+        queued += info.count;
+        if (survivors.count(info.processId))
+            demand = queued;
     }
+    return demand - res->availableInstances;
+}
 
-    // 3. Preempt victim's resources.
+// Checkpoint the victim's holdings (unless an earlier rollback's is still
+// outstanding), preempt all of them or only the shortfall of each resource
+// the survivors wait on, drop its waits and requeue whatever is missing
+// from the checkpoint. Whatever it keeps, no survivor is waiting for.
+// If there is nothing to preempt, the victim is left untouched (waits
+// included) and false is returned.
+bool RecoveryAgent::rollBack(ResourceManager &rm, int victimId, double cost, const unordered_set<int> &survivors,
+                             bool partial)
+{
     Process *victimProcessPtr = rm.findProcessById(victimId);
     if (!victimProcessPtr)
     {
-        rm.log("*** Recovery FAILED: Victim P" + to_string(victimId) + " not found. ***");
+        rm.log(LogEvent::RECOVERY_VICTIM_MISSING, victimId);
+        return false;
+    }
+    rm.log(LogEvent::VICTIM_SELECTED, victimId, lround(cost * 1000));
+
+    map<int, int> preempt; // <ResourceID, Instances to take>
+    for (const auto &pair : victimProcessPtr->resourcesHeld)
+    {
+        int count = pair.second;
+        if (partial)
+            count = min(count, shortfall(rm, pair.first, victimId, survivors));
+        if (count > 0 && rm.findResourceById(pair.first))
+            preempt[pair.first] = count;
+    }
+    if (preempt.empty())
+    {
+        rm.log(LogEvent::NOTHING_PREEMPTED, victimId);
         return false;
     }
     lastVictimProcess = victimProcessPtr;
-    rm.log("  - Selected P" + to_string(victimId) + " as victim (Cost: " + to_string(minCost) + ").");
-    lastVictimPreemptedResources = victimProcessPtr->resourcesHeld;
+    lastVictims.push_back(victimId);
 
-    for (const auto &pair : lastVictimPreemptedResources)
+    if (victimProcessPtr->checkpoint.empty())
+        victimProcessPtr->checkpoint = victimProcessPtr->resourcesHeld;
+    for (const auto &pair : preempt)
     {
-        Resource *res = rm.findResourceById(pair.first);
-        if (res)
+        rm.log(LogEvent::PREEMPTING, pair.second, pair.first, victimId);
+        rm.reclaimInstances(victimProcessPtr, rm.findResourceById(pair.first), pair.second);
+        lastVictimPreemptedResources[pair.first] += pair.second;
+    }
+    rm.resetWaitTimer(victimProcessPtr);
+    victimProcessPtr->rollbackCount++;
+    rm.changes.markProcess(rm.processSlots.at(victimId)); // Checkpoint and rollback count.
+
+    rm.log(LogEvent::REMOVING_FROM_WAITS, victimId);
+    rm.removeFromAllWaitLists(victimId);
+
+    // Behind the survivors, so they are served first.
+    if (partial)
+    {
+        for (const auto &pair : victimProcessPtr->checkpoint)
         {
-            rm.log("  - Preempting " + to_string(pair.second) + " of R" + to_string(pair.first) + " from P" + to_string(victimId));
-            res->availableInstances += pair.second;
+            auto kept = victimProcessPtr->resourcesHeld.find(pair.first);
+            int missing = pair.second - (kept != victimProcessPtr->resourcesHeld.end() ? kept->second : 0);
+            if (missing <= 0 || !rm.findResourceById(pair.first))
+                continue;
+            rm.addWaiter(pair.first, victimId, missing, true);
+            rm.log(LogEvent::REQUEUED, victimId, missing, pair.first);
         }
     }
-    victimProcessPtr->resourcesHeld.clear();
-    victimProcessPtr->resetWaitTime();
 
-    // 4. Remove victim from waiting lists.
-    rm.log("  - Removing P" + to_string(victimId) + " from wait lists.");
-    for (auto &pair : rm.waitingProcesses)
+    rm.log(LogEvent::RECOVERY_SUCCESS, victimId);
+    return true;
+}
+
+// Attempt deadlock recovery: roll back every victim of one plan.
+bool RecoveryAgent::initiateRecovery(ResourceManager &rm, bool fullPreemption)
+{
+    rm.log(LogEvent::DEADLOCK_DETECTED);
+    lastVictimProcess = nullptr;
+    lastVictims.clear();
+    lastVictimPreemptedResources.clear();
+
+    // 1. Identify deadlocked sets (exact components).
+    vector<vector<int>> deadlocks = rm.detector.findDeadlocks(rm);
+    if (deadlocks.empty())
+    {
+        rm.log(LogEvent::RECOVERY_NO_MEMBERS);
+        return false;
+    }
+
+    // 2. Plan victims.
+    map<int, double> costs;
+    vector<int> plan = planVictims(rm, deadlocks, costs);
+    if (plan.empty())
     {
-        auto &waiting_list = pair.second;
-        waiting_list.remove_if([victimId](const WaitingInfo &info)
-                               { return info.processId == victimId; });
+        rm.log(LogEvent::RECOVERY_NO_VICTIM);
+        return false;
     }
+    rm.log(LogEvent::RECOVERY_PLAN, plan.size());
 
-    rm.log("Recovery successful for P" + to_string(victimId) + ".");
-    return true;
-}
\ No newline at end of file
+    // 3. Roll the victims back.
+    unordered_set<int> survivors;
+    for (const auto &component : deadlocks)
+        survivors.insert(component.begin(), component.end());
+    for (int victimId : plan)
+        survivors.erase(victimId);
+    bool preempted = false;
+    for (int victimId : plan)
+    {
+        if (rollBack(rm, victimId, costs[victimId], survivors, partialPreemption && !fullPreemption))
+            preempted = true;
+    }
+    return preempted;
+}
@@ -4,4 +4,18 @@ using namespace std;
 
 // Resource constructor.
 Resource::Resource(int resourceId, int totalInstances)
-    : id(resourceId), totalInstances(totalInstances), availableInstances(totalInstances) {}
\ No newline at end of file
+    : id(resourceId), totalInstances(totalInstances), availableInstances(totalInstances) {}
+
+// Copy (atomics are not copyable on their own).
+Resource::Resource(const Resource &other)
+    : id(other.id), totalInstances(other.totalInstances),
+      availableInstances(other.availableInstances.load()), holders(other.holders) {}
+
+Resource &Resource::operator=(const Resource &other)
+{
+    id = other.id;
+    totalInstances = other.totalInstances;
+    availableInstances = other.availableInstances.load();
+    holders = other.holders;
+    return *this;
+}
\ No newline at end of file
@@ -3,105 +3,410 @@
 #include <algorithm>
 #include <vector>
 #include <map>
-#include <string> // for to_string
+#include <string>
 
 using namespace std;
 
 // Constructor.
 ResourceManager::ResourceManager() {}
 
-// Add a log message for the GUI.
-void ResourceManager::log(string message)
+// Toggle concurrent mode.
+void ResourceManager::setConcurrent(bool enabled)
 {
-    // We add messages to the front so the GUI log shows newest first.
-    // Or, append and have GUI auto-scroll. Let's append.
-    logMessages.push_back(message);
+    concurrent = enabled;
+    events.synchronized = enabled;
+    changes.synchronized = enabled;
+}
+
+// Exclusive state lock (concurrent mode only).
+unique_lock<StateGate> ResourceManager::lockState()
+{
+    if (!concurrent)
+        return unique_lock<StateGate>();
+    return unique_lock<StateGate>(stateGate);
+}
+
+// Conservation and index consistency check.
+bool ResourceManager::checkInvariants(string &error)
+{
+    unique_lock<StateGate> guard = lockState();
+    for (const auto &resource : resources)
+    {
+        int col = resourceSlots.at(resource.id);
+        int held = 0;
+        for (const auto &holder : resource.holders)
+        {
+            Process *process = findProcessById(holder.first);
+            if (!process || !process->resourcesHeld.count(resource.id) ||
+                process->resourcesHeld.at(resource.id) != holder.second)
+            {
+                error = "R" + to_string(resource.id) + ": holder index disagrees with P" + to_string(holder.first);
+                return false;
+            }
+            if (matrices.allocation[matrices.index(processSlots.at(holder.first), col)] != holder.second)
+            {
+                error = "R" + to_string(resource.id) + ": allocation matrix disagrees with P" + to_string(holder.first);
+                return false;
+            }
+            held += holder.second;
+        }
+        if (resource.availableInstances < 0 || resource.availableInstances + held != resource.totalInstances)
+        {
+            error = "R" + to_string(resource.id) + ": available " + to_string(resource.availableInstances) +
+                    " + held " + to_string(held) + " != total " + to_string(resource.totalInstances);
+            return false;
+        }
+    }
+    vector<int> requested(matrices.request.size(), 0);
+    unordered_map<int, size_t> groupedParts;
+    for (const auto &pair : waitingProcesses)
+    {
+        for (const auto &info : pair.second)
+        {
+            requested[matrices.index(processSlots.at(info.processId), resourceSlots.at(pair.first))] += info.count;
+            if (!info.grouped)
+                continue;
+            auto vec = queuedVectors.find(info.processId);
+            if (vec == queuedVectors.end() ||
+                find(vec->second.begin(), vec->second.end(), make_pair(pair.first, info.count)) == vec->second.end())
+            {
+                error = "P" + to_string(info.processId) + ": wait on R" + to_string(pair.first) + " is not in its request vector";
+                return false;
+            }
+            groupedParts[info.processId]++;
+        }
+    }
+    for (const auto &vec : queuedVectors)
+    {
+        if (groupedParts[vec.first] != vec.second.size())
+        {
+            error = "P" + to_string(vec.first) + ": request vector only partly queued";
+            return false;
+        }
+    }
+    if (requested != matrices.request)
+    {
+        error = "Request matrix disagrees with the wait queues";
+        return false;
+    }
+    for (const auto &process : processes)
+    {
+        for (const auto &pair : process.resourcesHeld)
+        {
+            if (pair.second <= 0 || !getHolders(pair.first).count(process.id))
+            {
+                error = "P" + to_string(process.id) + ": holding of R" + to_string(pair.first) + " not indexed";
+                return false;
+            }
+        }
+    }
+    return true;
 }
 
 // Set the active deadlock strategy.
 void ResourceManager::setStrategy(DeadlockStrategy newStrategy)
 {
+    unique_lock<StateGate> guard = lockState();
     this->strategy = newStrategy;
+    detector.invalidateSafetyCache();
     if (this->strategy == DeadlockStrategy::AVOID)
     {
-        log("[Strategy: Deadlock AVOIDANCE (Banker's Algorithm)]");
+        log(LogEvent::STRATEGY_AVOID);
     }
     else
     {
-        log("[Strategy: Deadlock DETECTION & RECOVERY (Graph Cycle)]");
+        log(LogEvent::STRATEGY_DETECT);
     }
 }
 
 // Add a process.
 void ResourceManager::addProcess(const Process &p)
 {
+    unique_lock<StateGate> guard = lockState();
+    if (processSlots.count(p.id))
+    {
+        log(LogEvent::DUPLICATE_PROCESS, p.id);
+        return;
+    }
+    processSlots[p.id] = processes.size();
     processes.push_back(p);
+    matrices.addRow();
+    changes.markProcess(processSlots[p.id]);
+    detector.invalidateSafetyCache();
 }
 
 // Add a resource.
 void ResourceManager::addResource(const Resource &r)
 {
+    unique_lock<StateGate> guard = lockState();
+    if (resourceSlots.count(r.id))
+    {
+        log(LogEvent::DUPLICATE_RESOURCE, r.id);
+        return;
+    }
+    resourceSlots[r.id] = resources.size();
     resources.push_back(r);
+    matrices.addColumn();
+    changes.markResource(resourceSlots[r.id]);
+    detector.invalidateSafetyCache();
 }
 
 // Declare max needs (Banker's).
 void ResourceManager::declareMaxResources(int processId, int resourceId, int maxCount)
 {
+    unique_lock<StateGate> guard = lockState();
     Process *process = findProcessById(processId);
     Resource *resource = findResourceById(resourceId);
     if (process && resource)
     {
         if (maxCount > resource->totalInstances)
         {
-            log("Warning: P" + to_string(processId) + " max (" + to_string(maxCount) + ") for R" + to_string(resourceId) + " > total (" + to_string(resource->totalInstances) + "). Clamping.");
+            log(LogEvent::MAX_CLAMPED, processId, maxCount, resourceId, resource->totalInstances);
             maxCount = resource->totalInstances;
         }
         process->maxResourcesNeeded[resourceId] = maxCount;
-        log("  - P" + to_string(processId) + " declared max R" + to_string(resourceId) + ": " + to_string(maxCount));
+        matrices.setMaxClaim(processSlots.at(processId), resourceSlots.at(resourceId), maxCount);
+        changes.markProcess(processSlots.at(processId));
+        detector.invalidateSafetyCache();
+        log(LogEvent::MAX_DECLARED, processId, resourceId, maxCount);
     }
     else
     {
-        log("Warning: Invalid P/R ID for max declaration.");
+        log(LogEvent::MAX_INVALID);
     }
 }
 
 // Find process.
 Process *ResourceManager::findProcessById(int processId)
 {
-    for (auto &p : processes)
-    {
-        if (p.id == processId)
-            return &p;
-    }
-    return nullptr;
+    auto it = processSlots.find(processId);
+    return it != processSlots.end() ? &processes[it->second] : nullptr;
 }
 
 // Find resource.
 Resource *ResourceManager::findResourceById(int resourceId)
 {
-    for (auto &r : resources)
+    auto it = resourceSlots.find(resourceId);
+    return it != resourceSlots.end() ? &resources[it->second] : nullptr;
+}
+
+// Holders of a resource (reverse index).
+const map<int, int> &ResourceManager::getHolders(int resourceId)
+{
+    static const map<int, int> noHolders;
+    Resource *resource = findResourceById(resourceId);
+    return resource ? resource->holders : noHolders;
+}
+
+// Move instances from a resource to a process.
+void ResourceManager::grantInstances(Process *process, Resource *resource, int count)
+{
+    resource->availableInstances -= count;
+    recordGrant(process, resource, count);
+}
+
+// Holdings, holder index, matrix and graph side of a grant.
+void ResourceManager::recordGrant(Process *process, Resource *resource, int count)
+{
+    int &held = process->resourcesHeld[resource->id];
+    bool newHolder = (held == 0);
+    held += count;
+    resource->holders[process->id] = held;
+
+    int row = processSlots.at(process->id);
+    int col = resourceSlots.at(resource->id);
+    matrices.addAllocation(row, col, count);
+    changes.markProcess(row);
+    changes.markResource(col);
+
+    // Back to its pre-rollback holdings: the checkpoint is spent.
+    if (!process->checkpoint.empty())
+    {
+        bool restored = true;
+        for (const auto &pair : process->checkpoint)
+        {
+            auto current = process->resourcesHeld.find(pair.first);
+            if (current == process->resourcesHeld.end() || current->second < pair.second)
+            {
+                restored = false;
+                break;
+            }
+        }
+        if (restored)
+            process->checkpoint.clear();
+    }
+
+    // New holder: everyone waiting on this resource now waits on it too.
+    if (newHolder && waitingProcesses.count(resource->id))
+    {
+        for (const auto &info : waitingProcesses.at(resource->id))
+            waitForGraph.addEdge(info.processId, process->id);
+    }
+}
+
+// Move instances from a process back to a resource.
+void ResourceManager::reclaimInstances(Process *process, Resource *resource, int count)
+{
+    resource->availableInstances += count;
+    int col = resourceSlots.at(resource->id);
+    changes.markResource(col);
+    auto it = process->resourcesHeld.find(resource->id);
+    if (it == process->resourcesHeld.end())
+        return;
+
+    it->second -= count;
+    int row = processSlots.at(process->id);
+    matrices.addAllocation(row, col, -count);
+    changes.markProcess(row);
+    if (it->second > 0)
+    {
+        resource->holders[process->id] = it->second;
+        return;
+    }
+
+    // No longer a holder: drop its incoming edges.
+    process->resourcesHeld.erase(it);
+    resource->holders.erase(process->id);
+    if (waitingProcesses.count(resource->id))
+    {
+        for (const auto &info : waitingProcesses.at(resource->id))
+            waitForGraph.removeEdge(info.processId, process->id);
+    }
+}
+
+// Queue a process on a resource. Returns false if already waiting.
+bool ResourceManager::addWaiter(int resourceId, int processId, int count, bool last, bool grouped)
+{
+    WaitQueue &queue = waitingProcesses[resourceId];
+    int priority = findProcessById(processId)->priority;
+    if (last && !queue.empty())
+        priority = min(priority, queue.lowestPriority());
+    if (!queue.push(WaitingInfo(processId, count, priority, nextWaitSeq++, grouped)))
+        return false;
+    totalWaiters++;
+    starvationGuardian.waiterAdded(processSlots.at(processId));
+    matrices.addRequest(processSlots.at(processId), resourceSlots.at(resourceId), count);
+    changes.markWaitQueue(resourceSlots.at(resourceId));
+    // A grouped part gets edges even if it fits now: the vector waits on
+    // every holder of every part. That over-approximates, so the detector
+    // confirms graph cycles by reduction while vectors are queued.
+    for (const auto &holder : getHolders(resourceId))
+        waitForGraph.addEdge(processId, holder.first);
+    return true;
+}
+
+// Dequeue a waiter. Returns the next list position.
+WaitQueue::iterator ResourceManager::removeWaiter(int resourceId, WaitQueue::iterator it)
+{
+    for (const auto &holder : getHolders(resourceId))
+        waitForGraph.removeEdge(it->processId, holder.first);
+    changes.markWaitQueue(resourceSlots.at(resourceId));
+    totalWaiters--;
+    starvationGuardian.waiterRemoved(processSlots.at(it->processId));
+    matrices.addRequest(processSlots.at(it->processId), resourceSlots.at(resourceId), -it->count);
+    return waitingProcesses.at(resourceId).erase(it);
+}
+
+// Clear a process's aging timer after progress.
+void ResourceManager::resetWaitTimer(Process *process)
+{
+    process->resetWaitTime();
+    starvationGuardian.timerReset(processSlots.at(process->id));
+}
+
+// Dequeue a process from every wait list.
+void ResourceManager::removeFromAllWaitLists(int processId)
+{
+    queuedVectors.erase(processId);
+    for (auto &pair : waitingProcesses)
+    {
+        auto it = pair.second.find(processId);
+        if (it != pair.second.end())
+            removeWaiter(pair.first, it);
+    }
+}
+
+// Its row of the request matrix says which queues it is in.
+void ResourceManager::updateWaiterPriority(Process *process)
+{
+    int row = processSlots.at(process->id);
+    for (int col = 0; col < matrices.cols; ++col)
     {
-        if (r.id == resourceId)
-            return &r;
+        if (matrices.request[matrices.index(row, col)] == 0)
+            continue;
+        auto queue = waitingProcesses.find(resources[col].id);
+        if (queue != waitingProcesses.end() && queue->second.setPriority(process->id, process->priority))
+            changes.markWaitQueue(col);
     }
-    return nullptr;
 }
 
 // Handle resource request.
 bool ResourceManager::requestResource(int processId, int resourceId, int count)
 {
-    log("P" + to_string(processId) + " requests " + to_string(count) + " of R" + to_string(resourceId));
+    clock.advance();
+    if (concurrent)
+    {
+        StateGate::Reader reader(stateGate);
+        if (reader.entered() && tryFastRequest(processId, resourceId, count))
+            return true;
+    }
+    unique_lock<StateGate> guard = lockState();
+    return requestLocked(processId, resourceId, count);
+}
+
+// Concurrent fast path: DETECT grant that fits, with nobody queued on
+// the resource (so no wait-for edges or waiter ordering are involved)
+// and the requester not waiting anywhere (so its aging timer is idle).
+bool ResourceManager::tryFastRequest(int processId, int resourceId, int count)
+{
+    if (strategy != DeadlockStrategy::DETECT || count <= 0)
+        return false;
+    auto processSlot = processSlots.find(processId);
+    auto resourceSlot = resourceSlots.find(resourceId);
+    if (processSlot == processSlots.end() || resourceSlot == resourceSlots.end())
+        return false;
+    auto waiting = waitingProcesses.find(resourceId);
+    if (waiting != waitingProcesses.end() && !waiting->second.empty())
+        return false;
+    if (starvationGuardian.isWaiting(processSlot->second))
+        return false;
+
+    // Claim the instances first: a request that does not fit backs out
+    // without taking any lock.
+    Process &process = processes[processSlot->second];
+    Resource &resource = resources[resourceSlot->second];
+    int available = resource.availableInstances.load(memory_order_relaxed);
+    do
+    {
+        if (available < count)
+            return false;
+    } while (!resource.availableInstances.compare_exchange_weak(available, available - count));
+
+    // Process stripe before resource stripe, always.
+    lock_guard<mutex> processGuard(processStripes[processSlot->second % LOCK_STRIPES]);
+    lock_guard<mutex> resourceGuard(resourceStripes[resourceSlot->second % LOCK_STRIPES]);
+    log(LogEvent::REQUEST, processId, count, resourceId);
+    recordGrant(&process, &resource, count);
+    log(LogEvent::GRANTED);
+    process.resetWaitTime();
+    return true;
+}
+
+// Serialized request.
+bool ResourceManager::requestLocked(int processId, int resourceId, int count)
+{
+    log(LogEvent::REQUEST, processId, count, resourceId);
     Process *process = findProcessById(processId);
     Resource *resource = findResourceById(resourceId);
 
     if (!process || !resource)
     {
-        log("Error: Invalid P/R ID in request.");
+        log(LogEvent::REQUEST_INVALID_ID);
         return false;
     }
     if (count <= 0)
     {
-        log("Error: Request count must be > 0.");
+        log(LogEvent::REQUEST_INVALID_COUNT);
         return false;
     }
 
@@ -116,7 +421,7 @@ bool ResourceManager::requestResource(int processId, int resourceId, int count)
         }
         else
         {
-            log("Error: P" + to_string(processId) + " requested R" + to_string(resourceId) + " but has no max need declared.");
+            log(LogEvent::REQUEST_NO_MAX, processId, resourceId);
             return false;
         }
 
@@ -127,71 +432,35 @@ bool ResourceManager::requestResource(int processId, int resourceId, int count)
         }
         if (count + current_allocation > max_need)
         {
-            log("Error: P" + to_string(processId) + " request exceeds declared max need.");
+            log(LogEvent::REQUEST_EXCEEDS_MAX, processId);
             return false;
         }
 
         if (count <= resource->availableInstances)
         {
-            log("  - Tentatively allocating for safety check...");
-            resource->availableInstances -= count;
-            process->resourcesHeld[resourceId] += count;
+            log(LogEvent::TENTATIVE_ALLOCATE);
+            grantInstances(process, resource, count);
 
-            if (detector.isSafeState(*this))
+            if (detector.isSafeAfterGrant(*this, processSlots.at(processId), resourceSlots.at(resourceId), count))
             {
-                log("Request GRANTED (Safe state).");
-                process->resetWaitTime();
+                log(LogEvent::GRANTED_SAFE);
+                resetWaitTimer(process);
                 return true;
             }
             else
             {
-                log("  - Rolling back (Unsafe state).");
-                resource->availableInstances += count;
-                process->resourcesHeld[resourceId] -= count;
-                if (process->resourcesHeld.at(resourceId) == 0)
-                {
-                    process->resourcesHeld.erase(resourceId);
-                }
-                log("Request DENIED (Unsafe). P" + to_string(processId) + " must wait.");
-                bool alreadyWaiting = false;
-                if (waitingProcesses.count(resourceId))
-                {
-                    for (const auto &info : waitingProcesses.at(resourceId))
-                    {
-                        if (info.processId == processId)
-                        {
-                            alreadyWaiting = true;
-                            break;
-                        }
-                    }
-                }
-                if (!alreadyWaiting)
-                {
-                    waitingProcesses[resourceId].emplace_back(processId, count);
-                }
+                log(LogEvent::ROLLBACK_UNSAFE);
+                reclaimInstances(process, resource, count);
+                log(LogEvent::DENIED_UNSAFE, processId);
+                addWaiter(resourceId, processId, count);
                 applyAgingToWaitingProcesses();
                 return false;
             }
         }
         else
         {
-            log("Request DENIED (Not enough). P" + to_string(processId) + " must wait.");
-            bool alreadyWaiting = false;
-            if (waitingProcesses.count(resourceId))
-            {
-                for (const auto &info : waitingProcesses.at(resourceId))
-                {
-                    if (info.processId == processId)
-                    {
-                        alreadyWaiting = true;
-                        break;
-                    }
-                }
-            }
-            if (!alreadyWaiting)
-            {
-                waitingProcesses[resourceId].emplace_back(processId, count);
-            }
+            log(LogEvent::DENIED_MUST_WAIT, processId);
+            addWaiter(resourceId, processId, count);
             applyAgingToWaitingProcesses();
             return false;
         }
@@ -201,80 +470,239 @@ bool ResourceManager::requestResource(int processId, int resourceId, int count)
         // --- Default: Deadlock Detection & Recovery Logic ---
         if (resource->availableInstances >= count)
         {
-            resource->availableInstances -= count;
-            process->resourcesHeld[resourceId] += count;
-            log("Request GRANTED.");
-            process->resetWaitTime();
+            grantInstances(process, resource, count);
+            log(LogEvent::GRANTED);
+            resetWaitTimer(process);
             return true;
         }
         else
         {
-            log("Request DENIED (Not enough). P" + to_string(processId) + " waits.");
-            bool alreadyWaiting = false;
-            if (waitingProcesses.count(resourceId))
+            log(LogEvent::DENIED_WAITS, processId);
+            addWaiter(resourceId, processId, count);
+            applyAgingToWaitingProcesses();
+
+            if (backgroundDetector.isRunning())
+            { // Detection happens off the request path.
+                backgroundDetector.noteWait();
+                return false;
+            }
+            resolveDeadlocks();
+            return false;
+        }
+    }
+}
+
+// Handle an all-or-nothing request (always serialized).
+bool ResourceManager::requestResources(int processId, const RequestVector &parts)
+{
+    clock.advance();
+    unique_lock<StateGate> guard = lockState();
+    return requestVectorLocked(processId, parts);
+}
+
+// Serialized vector request: the single-resource checks, applied to
+// every part before anything is granted or queued.
+bool ResourceManager::requestVectorLocked(int processId, const RequestVector &parts)
+{
+    log(LogEvent::REQUEST_VECTOR, processId, parts.size());
+    for (const auto &part : parts)
+        log(LogEvent::VECTOR_PART, part.second, part.first);
+
+    Process *process = findProcessById(processId);
+    if (!process || parts.empty())
+    {
+        log(LogEvent::REQUEST_INVALID_ID);
+        return false;
+    }
+    for (size_t i = 0; i < parts.size(); ++i)
+    {
+        int resourceId = parts[i].first;
+        if (!findResourceById(resourceId))
+        {
+            log(LogEvent::REQUEST_INVALID_ID);
+            return false;
+        }
+        if (parts[i].second <= 0)
+        {
+            log(LogEvent::REQUEST_INVALID_COUNT);
+            return false;
+        }
+        for (size_t j = 0; j < i; ++j)
+        {
+            if (parts[j].first == resourceId)
             {
-                for (const auto &info : waitingProcesses.at(resourceId))
-                {
-                    if (info.processId == processId)
-                    {
-                        alreadyWaiting = true;
-                        break;
-                    }
-                }
+                log(LogEvent::VECTOR_DUPLICATE, resourceId);
+                return false;
             }
-            if (!alreadyWaiting)
+        }
+        auto queue = waitingProcesses.find(resourceId);
+        if (queue != waitingProcesses.end() && queue->second.contains(processId))
+        {
+            log(LogEvent::ALREADY_WAITING, processId, resourceId);
+            return false;
+        }
+        if (strategy == DeadlockStrategy::AVOID)
+        {
+            auto max_need = process->maxResourcesNeeded.find(resourceId);
+            if (max_need == process->maxResourcesNeeded.end())
             {
-                waitingProcesses[resourceId].emplace_back(processId, count);
+                log(LogEvent::REQUEST_NO_MAX, processId, resourceId);
+                return false;
             }
-            applyAgingToWaitingProcesses();
-
-            if (detector.hasCycle(*this))
+            auto held = process->resourcesHeld.find(resourceId);
+            if (parts[i].second + (held != process->resourcesHeld.end() ? held->second : 0) > max_need->second)
             {
-                bool recovery_ok = recoveryAgent.initiateRecovery(*this);
-                if (recovery_ok)
-                {
-                    log("  - Post-recovery: Checking wait queues.");
-                    map<int, int> preempted = recoveryAgent.getPreemptedResources();
-                    for (const auto &pair : preempted)
-                    {
-                        checkWaitingProcesses(pair.first);
-                    }
-                }
-                else
-                {
-                    log("*** CRITICAL: Deadlock detected but RECOVERY FAILED! ***");
-                }
+                log(LogEvent::REQUEST_EXCEEDS_MAX, processId);
+                return false;
             }
-            return false;
         }
     }
+    if (queuedVectors.count(processId))
+    {
+        log(LogEvent::VECTOR_ALREADY_QUEUED, processId);
+        return false;
+    }
+
+    if (vectorFits(parts))
+    {
+        if (grantVector(process, parts))
+        {
+            log(strategy == DeadlockStrategy::AVOID ? LogEvent::GRANTED_SAFE : LogEvent::GRANTED);
+            resetWaitTimer(process);
+            return true;
+        }
+        log(LogEvent::DENIED_UNSAFE, processId);
+    }
+    else
+    {
+        log(strategy == DeadlockStrategy::AVOID ? LogEvent::DENIED_MUST_WAIT : LogEvent::DENIED_WAITS, processId);
+    }
+
+    // Queue every part; none is granted until all can be.
+    for (const auto &part : parts)
+        addWaiter(part.first, processId, part.second, false, true);
+    queuedVectors[processId] = parts;
+    applyAgingToWaitingProcesses();
+
+    if (strategy == DeadlockStrategy::DETECT)
+    {
+        if (backgroundDetector.isRunning())
+            backgroundDetector.noteWait();
+        else
+            resolveDeadlocks();
+    }
+    return false;
+}
+
+// Every part fits.
+bool ResourceManager::vectorFits(const RequestVector &parts)
+{
+    for (const auto &part : parts)
+    {
+        if (findResourceById(part.first)->availableInstances < part.second)
+            return false;
+    }
+    return true;
+}
+
+// Grant all parts; AVOID checks the combined grant once.
+bool ResourceManager::grantVector(Process *process, const RequestVector &parts)
+{
+    if (strategy == DeadlockStrategy::AVOID)
+        log(LogEvent::TENTATIVE_ALLOCATE);
+    for (const auto &part : parts)
+        grantInstances(process, findResourceById(part.first), part.second);
+    if (strategy != DeadlockStrategy::AVOID || detector.isSafeState(*this))
+        return true;
+
+    log(LogEvent::ROLLBACK_UNSAFE);
+    for (const auto &part : parts)
+        reclaimInstances(process, findResourceById(part.first), part.second);
+    return false;
+}
+
+// Drop every part of a queued vector. Emptied queues stay in the map
+// (checkWaitingProcesses may be iterating one of them).
+void ResourceManager::dequeueVector(int processId)
+{
+    auto vec = queuedVectors.find(processId);
+    if (vec == queuedVectors.end())
+        return;
+    for (const auto &part : vec->second)
+    {
+        auto queue = waitingProcesses.find(part.first);
+        if (queue == waitingProcesses.end())
+            continue;
+        auto it = queue->second.find(processId);
+        if (it != queue->second.end())
+            removeWaiter(part.first, it);
+    }
+    queuedVectors.erase(vec);
 }
 
 // Handle resource release.
 bool ResourceManager::releaseResource(int processId, int resourceId, int count)
 {
-    log("P" + to_string(processId) + " releases " + to_string(count) + " of R" + to_string(resourceId));
+    clock.advance();
+    if (concurrent)
+    {
+        StateGate::Reader reader(stateGate);
+        if (reader.entered() && tryFastRelease(processId, resourceId, count))
+            return true;
+    }
+    unique_lock<StateGate> guard = lockState();
+    return releaseLocked(processId, resourceId, count);
+}
+
+// Concurrent fast path: valid release while nobody waits anywhere
+// (so there are no waiters to wake and no aging to apply).
+bool ResourceManager::tryFastRelease(int processId, int resourceId, int count)
+{
+    if (totalWaiters > 0 || count <= 0)
+        return false;
+    auto processSlot = processSlots.find(processId);
+    auto resourceSlot = resourceSlots.find(resourceId);
+    if (processSlot == processSlots.end() || resourceSlot == resourceSlots.end())
+        return false;
+
+    lock_guard<mutex> processGuard(processStripes[processSlot->second % LOCK_STRIPES]);
+    lock_guard<mutex> resourceGuard(resourceStripes[resourceSlot->second % LOCK_STRIPES]);
+    Process &process = processes[processSlot->second];
+    Resource &resource = resources[resourceSlot->second];
+    auto held = process.resourcesHeld.find(resourceId);
+    if (held == process.resourcesHeld.end() || held->second < count)
+        return false;
+
+    log(LogEvent::RELEASE, processId, count, resourceId);
+    process.checkpoint.clear(); // It moved on from what it was rolled back from.
+    reclaimInstances(&process, &resource, count);
+    log(LogEvent::RELEASED, resourceId, resource.availableInstances);
+    return true;
+}
+
+// Serialized release.
+bool ResourceManager::releaseLocked(int processId, int resourceId, int count)
+{
+    log(LogEvent::RELEASE, processId, count, resourceId);
     Process *process = findProcessById(processId);
     Resource *resource = findResourceById(resourceId);
 
     if (!process || !resource)
     {
-        log("Error: Invalid P/R ID in release.");
+        log(LogEvent::RELEASE_INVALID_ID);
         return false;
     }
     if (count <= 0)
     {
-        log("Error: Release count must be > 0.");
+        log(LogEvent::RELEASE_INVALID_COUNT);
         return false;
     }
 
     if (process->resourcesHeld.count(resourceId) && process->resourcesHeld.at(resourceId) >= count)
     {
-        process->resourcesHeld[resourceId] -= count;
-        if (process->resourcesHeld[resourceId] == 0)
-            process->resourcesHeld.erase(resourceId);
-        resource->availableInstances += count;
-        log("R" + to_string(resourceId) + " released (Available: " + to_string(resource->availableInstances) + ").");
+        process->checkpoint.clear(); // It moved on from what it was rolled back from.
+        reclaimInstances(process, resource, count);
+        log(LogEvent::RELEASED, resourceId, resource->availableInstances);
 
         checkWaitingProcesses(resourceId);
         applyAgingToWaitingProcesses();
@@ -282,94 +710,157 @@ bool ResourceManager::releaseResource(int processId, int resourceId, int count)
     }
     else
     {
-        log("Error: P" + to_string(processId) + " cannot release " + to_string(count) + " of R" + to_string(resourceId) + " (Holds: " + (process->resourcesHeld.count(resourceId) ? to_string(process->resourcesHeld.at(resourceId)) : "0") + ").");
+        log(LogEvent::RELEASE_TOO_MANY, processId, count, resourceId, process->resourcesHeld.count(resourceId) ? process->resourcesHeld.at(resourceId) : 0);
         return false;
     }
 }
 
-// Check waiting list.
+// Recover, then serve waiters of the preempted resources.
+bool ResourceManager::recoverFromDeadlock(bool fullPreemption)
+{
+    bool recovery_ok = recoveryAgent.initiateRecovery(*this, fullPreemption);
+    if (recovery_ok)
+    {
+        log(LogEvent::POST_RECOVERY_CHECK);
+        map<int, int> preempted = recoveryAgent.getPreemptedResources();
+        for (const auto &pair : preempted)
+        {
+            checkWaitingProcesses(pair.first);
+        }
+    }
+    else
+    {
+        log(LogEvent::RECOVERY_CRITICAL);
+    }
+    return recovery_ok;
+}
+
+// Recover until no deadlock is left. The waiters served after a recovery
+// go in queue order, which the victim plan does not model: one queued
+// ahead of a survivor (or a partially rolled-back victim itself) can take
+// the freed instances and deadlock again. Later rounds therefore preempt
+// fully, as the plan assumes. Bounded; stops when nothing is preempted.
+void ResourceManager::resolveDeadlocks()
+{
+    size_t rounds = 0;
+    while (rounds++ < processes.size() && detector.hasDeadlock(*this))
+    {
+        if (!recoverFromDeadlock(rounds > 1))
+            break;
+    }
+}
+
+// Check waiting list. Only waiters whose request fits what is free are
+// visited (in service order); nothing is, if even the smallest is too big.
 void ResourceManager::checkWaitingProcesses(int resourceId)
 {
     Resource *resource = findResourceById(resourceId);
-    if (!resource || waitingProcesses.find(resourceId) == waitingProcesses.end() || waitingProcesses.at(resourceId).empty())
+    auto queue = waitingProcesses.find(resourceId);
+    if (!resource || queue == waitingProcesses.end() || queue->second.empty())
     {
         return;
     }
 
-    auto &waiting_list = waitingProcesses.at(resourceId);
-    log("  - Checking waits for R" + to_string(resourceId) + " (Available: " + to_string(resource->availableInstances) + ")");
+    WaitQueue &waiting_list = queue->second;
+    if (resource->availableInstances < waiting_list.smallestRequest())
+        return;
+    log(LogEvent::CHECK_WAITS, resourceId, resource->availableInstances);
 
-    for (auto it = waiting_list.begin(); it != waiting_list.end(); /* manual */)
+    WaitingInfo info(0, 0);
+    for (auto it = waiting_list.nextFitting(resource->availableInstances); it != waiting_list.end();
+         it = waiting_list.nextFitting(resource->availableInstances, &info))
     {
-        WaitingInfo &info = *it;
+        info = *it;
         Process *waitingProcess = findProcessById(info.processId);
 
         if (!waitingProcess)
         {
-            it = waiting_list.erase(it);
+            removeWaiter(resourceId, it);
+            continue;
+        }
+
+        if (info.grouped)
+        {
+            // --- Request vector: all parts at once, or none ---
+            RequestVector parts = queuedVectors.at(info.processId);
+            if (!vectorFits(parts))
+                continue;
+            if (strategy == DeadlockStrategy::DETECT)
+                dequeueVector(info.processId);
+            if (!grantVector(waitingProcess, parts))
+            {
+                log(LogEvent::WAITER_UNSAFE, info.processId);
+                continue;
+            }
+            dequeueVector(info.processId);
+            log(LogEvent::VECTOR_WAITER_GRANTED, info.processId, parts.size());
+            resetWaitTimer(waitingProcess);
             continue;
         }
 
-        if (resource->availableInstances >= info.count)
+        if (strategy == DeadlockStrategy::AVOID)
         {
-            if (strategy == DeadlockStrategy::AVOID)
+            // --- Banker's: Check safety before granting to waiter ---
+            log(LogEvent::TENTATIVE_GRANT_WAITER, info.processId);
+            grantInstances(waitingProcess, resource, info.count);
+
+            if (detector.isSafeAfterGrant(*this, processSlots.at(info.processId), resourceSlots.at(resourceId), info.count))
             {
-                // --- Banker's: Check safety before granting to waiter ---
-                log("  - Tentatively granting to P" + to_string(info.processId) + " (pending safety check)...");
-                resource->availableInstances -= info.count;
-                waitingProcess->resourcesHeld[resourceId] += info.count;
-
-                if (detector.isSafeState(*this))
-                {
-                    log("    - Granting " + to_string(info.count) + " of R" + to_string(resourceId) + " to P" + to_string(info.processId) + " (Safe).");
-                    waitingProcess->resetWaitTime();
-                    it = waiting_list.erase(it);
-                }
-                else
-                {
-                    log("    - Cannot grant to P" + to_string(info.processId) + " (unsafe). Rolling back.");
-                    resource->availableInstances += info.count;
-                    waitingProcess->resourcesHeld[resourceId] -= info.count;
-                    if (waitingProcess->resourcesHeld.at(resourceId) == 0)
-                        waitingProcess->resourcesHeld.erase(resourceId);
-                    ++it;
-                }
+                log(LogEvent::WAITER_GRANTED_SAFE, info.count, resourceId, info.processId);
+                resetWaitTimer(waitingProcess);
+                removeWaiter(resourceId, it);
             }
             else
             {
-                // --- Detection: Grant if available ---
-                log("    - Granting " + to_string(info.count) + " of R" + to_string(resourceId) + " to P" + to_string(info.processId) + ".");
-                resource->availableInstances -= info.count;
-                waitingProcess->resourcesHeld[resourceId] += info.count;
-                waitingProcess->resetWaitTime();
-                it = waiting_list.erase(it);
+                log(LogEvent::WAITER_UNSAFE, info.processId);
+                reclaimInstances(waitingProcess, resource, info.count);
             }
         }
         else
         {
-            ++it; // Not enough, check next waiter.
+            // --- Detection: Grant if available ---
+            log(LogEvent::WAITER_GRANTED, info.count, resourceId, info.processId);
+            removeWaiter(resourceId, it);
+            grantInstances(waitingProcess, resource, info.count);
+            resetWaitTimer(waitingProcess);
         }
     }
     if (waiting_list.empty())
-        waitingProcesses.erase(resourceId);
+        waitingProcesses.erase(queue);
 }
 
 // Trigger aging check.
 void ResourceManager::applyAgingToWaitingProcesses()
 {
-    bool anyWaiting = false;
-    for (const auto &pair : waitingProcesses)
-    {
-        if (!pair.second.empty())
-        {
-            anyWaiting = true;
-            break;
-        }
-    }
-    if (anyWaiting)
+    if (totalWaiters > 0)
     {
-        log("--- Applying Aging Check ---");
+        log(LogEvent::AGING_CHECK);
         starvationGuardian.applyAging(*this);
         // Note: StarvationGuardian adds its own logs.
     }
+}
+
+// Switch time source.
+void ResourceManager::setClockSource(ClockSource source)
+{
+    unique_lock<StateGate> guard = lockState();
+    clock.setSource(source);
+    starvationGuardian.restartTimers(*this);
+    log(LogEvent::CLOCK_SOURCE, static_cast<int>(source));
+    applyAgingToWaitingProcesses();
+}
+
+// Advance virtual time.
+bool ResourceManager::advanceClock(long long ticks)
+{
+    unique_lock<StateGate> guard = lockState();
+    if (!clock.isVirtual())
+    {
+        log(LogEvent::CLOCK_NOT_VIRTUAL);
+        return false;
+    }
+    clock.advance(ticks);
+    log(LogEvent::CLOCK_ADVANCED, static_cast<int>(ticks));
+    applyAgingToWaitingProcesses();
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+#include "../include/SimClock.h"
+#include <chrono>
+
+using namespace std;
+
+// Read the active source.
+long long SimClock::now() const
+{
+    ClockSource current = getSource();
+    if (current == ClockSource::VIRTUAL)
+        return ticks.load(memory_order_relaxed);
+    if (current == ClockSource::MONOTONIC) // +1: never 0, even right after boot.
+        return chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now().time_since_epoch()).count() + 1;
+    return chrono::duration_cast<chrono::seconds>(chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Step virtual time forward.
+void SimClock::advance(long long n)
+{
+    if (isVirtual() && n > 0)
+        ticks.fetch_add(n, memory_order_relaxed);
+}
@@ -1,63 +1,106 @@
 #include "../include/StarvationGuardian.h"
 #include "../include/ResourceManager.h"
 #include <iostream>
-#include <chrono>
-#include <set>
 #include <string>
 
 using namespace std;
 
+// Grow the per-slot arrays to cover a slot.
+void StarvationGuardian::ensureSlot(int slot)
+{
+    if (slot >= (int)queuedOn.size())
+    {
+        queuedOn.resize(slot + 1, 0);
+        epochs.resize(slot + 1, 0);
+    }
+}
+
+// Process joined a wait queue.
+void StarvationGuardian::waiterAdded(int slot)
+{
+    ensureSlot(slot);
+    if (queuedOn[slot]++ == 0)
+        started.push_back(slot);
+}
+
+// Process left a wait queue.
+void StarvationGuardian::waiterRemoved(int slot)
+{
+    ensureSlot(slot);
+    if (queuedOn[slot] > 0 && --queuedOn[slot] == 0)
+        stopped.push_back(slot);
+}
+
+// Timer cleared by a grant.
+void StarvationGuardian::timerReset(int slot)
+{
+    ensureSlot(slot);
+    epochs[slot]++;
+    if (queuedOn[slot] > 0)
+        started.push_back(slot);
+}
+
+// Old timestamps are in the old clock's units: start every waiter afresh.
+void StarvationGuardian::restartTimers(ResourceManager &rm)
+{
+    deadlines = decltype(deadlines)();
+    for (int slot = 0; slot < (int)queuedOn.size(); ++slot)
+    {
+        epochs[slot]++;
+        rm.processes[slot].resetWaitTime();
+        if (queuedOn[slot] > 0)
+            started.push_back(slot);
+    }
+}
+
 // Apply Aging.
 void StarvationGuardian::applyAging(ResourceManager &rm)
 {
-    long long currentTime = chrono::duration_cast<chrono::seconds>(
-                                chrono::system_clock::now().time_since_epoch())
-                                .count();
+    long long currentTime = rm.clock.now();
 
-    // Get all waiting process IDs.
-    set<int> currentlyWaitingIds;
-    for (const auto &pair : rm.waitingProcesses)
+    // Reset timers of processes no longer waiting.
+    for (int slot : stopped)
     {
-        for (const auto &waitingInfo : pair.second)
+        Process &process = rm.processes[slot];
+        if (queuedOn[slot] > 0)
+            continue;
+        epochs[slot]++;
+        if (process.waitStartTime != 0)
         {
-            currentlyWaitingIds.insert(waitingInfo.processId);
+            rm.log(LogEvent::AGING_STOPPED, process.id);
+            process.resetWaitTime();
         }
     }
+    stopped.clear();
 
-    // Check each process.
-    for (auto &process : rm.processes)
+    // Start timers of new waiters.
+    for (int slot : started)
     {
-        bool isWaiting = (currentlyWaitingIds.count(process.id) > 0);
+        Process &process = rm.processes[slot];
+        if (queuedOn[slot] == 0 || process.waitStartTime != 0)
+            continue;
+        epochs[slot]++;
+        process.waitStartTime = currentTime;
+        process.waitingSince = currentTime;
+        rm.log(LogEvent::AGING_STARTED, process.id);
+        deadlines.push({currentTime + agingThreshold, slot, epochs[slot]});
+    }
+    started.clear();
 
-        if (isWaiting)
-        {
-            if (process.waitStartTime == 0)
-            {
-                // Start wait timer.
-                process.waitStartTime = currentTime;
-                rm.log("  - Aging: P" + to_string(process.id) + " started waiting.");
-            }
-            else
-            {
-                // Check timer.
-                long long waitDuration = currentTime - process.waitStartTime;
-                const long long AGING_THRESHOLD = 5; // 5 second threshold.
-                if (waitDuration > AGING_THRESHOLD)
-                {
-                    process.increasePriority();
-                    rm.log("*** Aging: Increased P" + to_string(process.id) + " priority to " + to_string(process.priority) + " ***");
-                    process.waitStartTime = currentTime; // Reset timer.
-                }
-            }
-        }
-        else
-        {
-            // Reset timer if no longer waiting.
-            if (process.waitStartTime != 0)
-            {
-                rm.log("  - Aging: P" + to_string(process.id) + " stopped waiting.");
-                process.resetWaitTime();
-            }
-        }
+    // Boost every waiter whose threshold has passed.
+    while (!deadlines.empty() && deadlines.top().due < currentTime)
+    {
+        Deadline expired = deadlines.top();
+        deadlines.pop();
+        if (expired.epoch != epochs[expired.slot] || queuedOn[expired.slot] == 0)
+            continue; // Timer was reset or stopped since.
+
+        Process &process = rm.processes[expired.slot];
+        process.increasePriority();
+        rm.updateWaiterPriority(&process);
+        rm.changes.markProcess(expired.slot);
+        rm.log(LogEvent::AGING_BOOST, process.id, process.priority);
+        process.waitStartTime = currentTime; // Reset timer.
+        deadlines.push({currentTime + agingThreshold, expired.slot, epochs[expired.slot]});
     }
-}
\ No newline at end of file
+}
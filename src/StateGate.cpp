@@ -0,0 +1,51 @@
+#include "../include/StateGate.h"
+#include <thread>
+
+using namespace std;
+
+// Threads are spread over the slots round-robin.
+int StateGate::readerSlot()
+{
+    static atomic<int> nextSlot{0};
+    thread_local int slot = nextSlot.fetch_add(1, memory_order_relaxed) % READER_SLOTS;
+    return slot;
+}
+
+// Announce the reader, then check for a writer. The writer does the
+// mirror image (flag, then counters), so one of them always sees the other.
+int StateGate::tryEnterShared()
+{
+    int slot = readerSlot();
+    readers[slot].count.fetch_add(1);
+    if (writerActive.load())
+    {
+        readers[slot].count.fetch_sub(1, memory_order_release);
+        return -1;
+    }
+    return slot;
+}
+
+// Leave the shared side.
+void StateGate::exitShared(int slot)
+{
+    readers[slot].count.fetch_sub(1, memory_order_release);
+}
+
+// Block new readers and wait for the current ones to leave.
+void StateGate::lock()
+{
+    writerLock.lock();
+    writerActive.store(true);
+    for (auto &reader : readers)
+    {
+        while (reader.count.load() != 0)
+            this_thread::yield();
+    }
+}
+
+// Reopen the gate.
+void StateGate::unlock()
+{
+    writerActive.store(false, memory_order_release);
+    writerLock.unlock();
+}
@@ -0,0 +1,79 @@
+#include "../include/ThreadPool.h"
+#include <atomic>
+#include <algorithm>
+
+using namespace std;
+
+// Start the workers.
+ThreadPool::ThreadPool(int threads)
+{
+    for (int i = 0; i < threads; ++i)
+        workers.emplace_back(&ThreadPool::work, this);
+}
+
+// Finish queued tasks, then join.
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(queueLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+// Worker loop.
+void ThreadPool::work()
+{
+    while (true)
+    {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(queueLock);
+            wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+                return;
+            task = move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+// Indices are handed out dynamically, so uneven items balance out.
+void ThreadPool::parallelFor(int n, const function<void(int)> &fn)
+{
+    if (n <= 0)
+        return;
+
+    atomic<int> next{0};
+    auto drain = [&]
+    {
+        for (int i = next++; i < n; i = next++)
+            fn(i);
+    };
+
+    int helpers = min(size(), n - 1);
+    mutex doneLock;
+    condition_variable doneWake;
+    int finished = 0;
+    {
+        lock_guard<mutex> lock(queueLock);
+        for (int h = 0; h < helpers; ++h)
+        {
+            tasks.emplace_back([&]
+            {
+                drain();
+                lock_guard<mutex> done(doneLock);
+                if (++finished == helpers)
+                    doneWake.notify_one();
+            });
+        }
+    }
+    wake.notify_all();
+
+    drain();
+    unique_lock<mutex> done(doneLock);
+    doneWake.wait(done, [&] { return finished == helpers; });
+}
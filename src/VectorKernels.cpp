@@ -0,0 +1,164 @@
+#include "../include/VectorKernels.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define DM_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// --- Scalar (portable) ---
+
+static bool rowFitsScalar(const int *need, const int *work, int m)
+{
+    for (int j = 0; j < m; ++j)
+    {
+        if (need[j] > work[j])
+            return false;
+    }
+    return true;
+}
+
+static void rowAccumulateScalar(int *work, const int *allocation, int m)
+{
+    for (int j = 0; j < m; ++j)
+        work[j] += allocation[j];
+}
+
+#ifdef DM_X86_KERNELS
+
+// --- SSE4.1 (4 ints per step) ---
+
+__attribute__((target("sse4.1"))) static bool rowFitsSse41(const int *need, const int *work, int m)
+{
+    int j = 0;
+    for (; j + 4 <= m; j += 4)
+    {
+        __m128i n = _mm_loadu_si128(reinterpret_cast<const __m128i *>(need + j));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(work + j));
+        __m128i over = _mm_cmpgt_epi32(n, w);
+        if (!_mm_testz_si128(over, over))
+            return false;
+    }
+    return rowFitsScalar(need + j, work + j, m - j);
+}
+
+__attribute__((target("sse4.1"))) static void rowAccumulateSse41(int *work, const int *allocation, int m)
+{
+    int j = 0;
+    for (; j + 4 <= m; j += 4)
+    {
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(work + j));
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(allocation + j));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(work + j), _mm_add_epi32(w, a));
+    }
+    rowAccumulateScalar(work + j, allocation + j, m - j);
+}
+
+// --- AVX2 (8 ints per step) ---
+
+__attribute__((target("avx2"))) static bool rowFitsAvx2(const int *need, const int *work, int m)
+{
+    int j = 0;
+    for (; j + 8 <= m; j += 8)
+    {
+        __m256i n = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(need + j));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(work + j));
+        __m256i over = _mm256_cmpgt_epi32(n, w);
+        if (!_mm256_testz_si256(over, over))
+            return false;
+    }
+    return rowFitsScalar(need + j, work + j, m - j);
+}
+
+__attribute__((target("avx2"))) static void rowAccumulateAvx2(int *work, const int *allocation, int m)
+{
+    int j = 0;
+    for (; j + 8 <= m; j += 8)
+    {
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(work + j));
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(allocation + j));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(work + j), _mm256_add_epi32(w, a));
+    }
+    rowAccumulateScalar(work + j, allocation + j, m - j);
+}
+
+#endif
+
+// --- Dispatch ---
+
+// Constant-initialized to scalar, so calls made during other translation
+// units' static initialization (before kernelsSelected runs) are safe.
+static bool (*rowFitsImpl)(const int *, const int *, int) = rowFitsScalar;
+static void (*rowAccumulateImpl)(int *, const int *, int) = rowAccumulateScalar;
+static KernelSet activeKernels = KernelSet::SCALAR;
+
+KernelSet bestKernelSet()
+{
+#ifdef DM_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return KernelSet::AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return KernelSet::SSE41;
+#endif
+    return KernelSet::SCALAR;
+}
+
+bool selectKernelSet(KernelSet kernels)
+{
+    if (static_cast<int>(kernels) > static_cast<int>(bestKernelSet()))
+        return false;
+
+    switch (kernels)
+    {
+#ifdef DM_X86_KERNELS
+    case KernelSet::AVX2:
+        rowFitsImpl = rowFitsAvx2;
+        rowAccumulateImpl = rowAccumulateAvx2;
+        break;
+    case KernelSet::SSE41:
+        rowFitsImpl = rowFitsSse41;
+        rowAccumulateImpl = rowAccumulateSse41;
+        break;
+#endif
+    default:
+        rowFitsImpl = rowFitsScalar;
+        rowAccumulateImpl = rowAccumulateScalar;
+        kernels = KernelSet::SCALAR;
+        break;
+    }
+    activeKernels = kernels;
+    return true;
+}
+
+// Pick the best kernels once, at startup.
+static const bool kernelsSelected = selectKernelSet(bestKernelSet());
+
+KernelSet activeKernelSet()
+{
+    return activeKernels;
+}
+
+const char *kernelSetName(KernelSet kernels)
+{
+    switch (kernels)
+    {
+    case KernelSet::AVX2:
+        return "AVX2";
+    case KernelSet::SSE41:
+        return "SSE4.1";
+    default:
+        return "Scalar";
+    }
+}
+
+bool rowFits(const int *need, const int *work, int m)
+{
+    return rowFitsImpl(need, work, m);
+}
+
+void rowAccumulate(int *work, const int *allocation, int m)
+{
+    rowAccumulateImpl(work, allocation, m);
+}
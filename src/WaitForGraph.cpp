@@ -0,0 +1,292 @@
+#include "../include/WaitForGraph.h"
+#include "../include/ThreadPool.h"
+#include <chrono>
+#include <algorithm>
+
+using namespace std;
+
+// Add one waiter -> holder edge. A process waiting on a resource it
+// partly holds does not wait on itself, so self-edges are never stored.
+void WaitForGraph::addEdge(int waiterId, int holderId)
+{
+    if (waiterId == holderId)
+        return;
+    edges[waiterId][holderId]++;
+    if (!pendingSources.count(waiterId))
+    {
+        long long now = timed ? chrono::duration_cast<chrono::nanoseconds>(
+                                    chrono::steady_clock::now().time_since_epoch())
+                                    .count()
+                              : 0;
+        pendingSources.emplace(waiterId, now);
+    }
+}
+
+// Remove one waiter -> holder edge.
+void WaitForGraph::removeEdge(int waiterId, int holderId)
+{
+    if (waiterId == holderId)
+        return;
+    auto it = edges.find(waiterId);
+    if (it == edges.end())
+        return;
+
+    auto edge = it->second.find(holderId);
+    if (edge == it->second.end())
+        return;
+
+    if (--edge->second == 0)
+    {
+        it->second.erase(edge);
+        if (it->second.empty())
+            edges.erase(it);
+    }
+}
+
+// Iterative DFS from 'source' looking for a path back to it.
+bool WaitForGraph::cycleThrough(int source)
+{
+    visited.clear();
+    stack.clear();
+    stack.push_back(source);
+    visited.insert(source);
+
+    while (!stack.empty())
+    {
+        int u = stack.back();
+        stack.pop_back();
+
+        auto it = edges.find(u);
+        if (it == edges.end())
+            continue;
+
+        for (const auto &edge : it->second)
+        {
+            int v = edge.first;
+            if (v == source)
+                return true; // Cycle.
+            if (visited.insert(v).second)
+                stack.push_back(v);
+        }
+    }
+    return false;
+}
+
+// Check only the sources of new edges.
+// Removing edges can only break cycles, so nothing else needs a look.
+bool WaitForGraph::hasCycle()
+{
+    for (auto it = pendingSources.begin(); it != pendingSources.end();)
+    {
+        int source = it->first;
+        if (edges.count(source) && cycleThrough(source))
+        {
+            cycleSince = it->second;
+            return true; // Keep it pending until the cycle is broken.
+        }
+        it = pendingSources.erase(it);
+    }
+    return false;
+}
+
+// Number the nodes and lay the edges out contiguously.
+void WaitForGraph::buildSnapshot(const vector<int> *scope)
+{
+    nodeIds.clear();
+    nodeIndex.clear();
+    auto indexOf = [this](int id)
+    {
+        auto it = nodeIndex.emplace(id, (int)nodeIds.size());
+        if (it.second)
+            nodeIds.push_back(id);
+        return it.first->second;
+    };
+    if (scope)
+    {
+        for (int id : *scope)
+            indexOf(id);
+    }
+    else
+    {
+        for (const auto &pair : edges)
+        {
+            indexOf(pair.first);
+            for (const auto &edge : pair.second)
+                indexOf(edge.first);
+        }
+    }
+
+    // Only edges between indexed nodes.
+    int n = nodeIds.size();
+    adjStart.assign(n + 1, 0);
+    adj.clear();
+    for (int u = 0; u < n; ++u)
+    {
+        auto it = edges.find(nodeIds[u]);
+        if (it != edges.end())
+        {
+            for (const auto &edge : it->second)
+            {
+                auto target = nodeIndex.find(edge.first);
+                if (target == nodeIndex.end())
+                    continue;
+                adj.push_back(target->second);
+            }
+        }
+        adjStart[u + 1] = adj.size();
+    }
+
+    order.assign(n, -1);
+    low.assign(n, 0);
+    onStack.assign(n, 0);
+}
+
+// Tarjan's algorithm with an explicit call stack (no recursion).
+void WaitForGraph::tarjan(const vector<int> &roots, vector<vector<int>> &out)
+{
+    vector<pair<int, int>> calls; // <Node, next edge position>
+    vector<int> members;
+    int counter = 0;
+
+    for (int root : roots)
+    {
+        if (order[root] != -1)
+            continue;
+
+        order[root] = low[root] = counter++;
+        members.push_back(root);
+        onStack[root] = 1;
+        calls.emplace_back(root, adjStart[root]);
+
+        while (!calls.empty())
+        {
+            int v = calls.back().first;
+            int &next = calls.back().second;
+            if (next < adjStart[v + 1])
+            {
+                int w = adj[next++];
+                if (order[w] == -1)
+                {
+                    order[w] = low[w] = counter++;
+                    members.push_back(w);
+                    onStack[w] = 1;
+                    calls.emplace_back(w, adjStart[w]);
+                }
+                else if (onStack[w])
+                {
+                    low[v] = min(low[v], order[w]);
+                }
+                continue;
+            }
+
+            // v is finished.
+            calls.pop_back();
+            if (!calls.empty())
+            {
+                int parent = calls.back().first;
+                low[parent] = min(low[parent], low[v]);
+            }
+            if (low[v] != order[v])
+                continue;
+
+            // v roots a component: pop it.
+            vector<int> component;
+            int w;
+            do
+            {
+                w = members.back();
+                members.pop_back();
+                onStack[w] = 0;
+                component.push_back(nodeIds[w]);
+            } while (w != v);
+
+            if (component.size() > 1) // No self-edges, so a cycle needs two.
+            {
+                sort(component.begin(), component.end());
+                out.push_back(move(component));
+            }
+        }
+    }
+}
+
+// Deadlocked components of an induced subgraph.
+vector<vector<int>> WaitForGraph::deadlockedComponentsAmong(const vector<int> &nodes)
+{
+    buildSnapshot(&nodes);
+    int n = nodeIds.size();
+    vector<int> roots(n);
+    for (int i = 0; i < n; ++i)
+        roots[i] = i;
+    vector<vector<int>> components;
+    tarjan(roots, components);
+    sort(components.begin(), components.end(),
+         [](const vector<int> &a, const vector<int> &b) { return a.front() < b.front(); });
+    return components;
+}
+
+// All deadlocked components.
+vector<vector<int>> WaitForGraph::deadlockedComponents(ThreadPool *pool)
+{
+    // Below this many nodes the split is not worth the hand-off.
+    const int PARALLEL_MIN_NODES = 4096;
+
+    buildSnapshot();
+    int n = nodeIds.size();
+    vector<vector<int>> components;
+
+    if (!pool || pool->size() == 0 || n < PARALLEL_MIN_NODES)
+    {
+        vector<int> roots(n);
+        for (int i = 0; i < n; ++i)
+            roots[i] = i;
+        tarjan(roots, components);
+    }
+    else
+    {
+        // Weakly connected components (union-find); no edge crosses them,
+        // so each can be searched independently.
+        vector<int> parent(n);
+        for (int i = 0; i < n; ++i)
+            parent[i] = i;
+        auto find = [&parent](int x)
+        {
+            while (parent[x] != x)
+                x = parent[x] = parent[parent[x]];
+            return x;
+        };
+        for (int u = 0; u < n; ++u)
+        {
+            for (int k = adjStart[u]; k < adjStart[u + 1]; ++k)
+            {
+                int a = find(u), b = find(adj[k]);
+                if (a != b)
+                    parent[a] = b;
+            }
+        }
+
+        vector<int> groupOf(n, -1);
+        vector<vector<int>> groups;
+        for (int i = 0; i < n; ++i)
+        {
+            int r = find(i);
+            if (groupOf[r] == -1)
+            {
+                groupOf[r] = groups.size();
+                groups.emplace_back();
+            }
+            groups[groupOf[r]].push_back(i);
+        }
+
+        vector<vector<vector<int>>> found(groups.size());
+        pool->parallelFor(groups.size(), [&](int g) { tarjan(groups[g], found[g]); });
+        for (auto &group : found)
+        {
+            for (auto &component : group)
+                components.push_back(move(component));
+        }
+    }
+
+    sort(components.begin(), components.end(),
+         [](const vector<int> &a, const vector<int> &b) { return a.front() < b.front(); });
+    return components;
+}
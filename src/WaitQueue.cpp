@@ -0,0 +1,68 @@
+#include "../include/WaitQueue.h"
+
+using namespace std;
+
+// Insert in service order and index it.
+bool WaitQueue::push(const WaitingInfo &info)
+{
+    if (byProcess.count(info.processId))
+        return false;
+    byProcess.emplace(info.processId, entries.insert(info).first);
+    byCount[info.count].insert(info);
+    return true;
+}
+
+// Drop an entry's copy from its count bucket.
+void WaitQueue::unbucket(const WaitingInfo &info)
+{
+    auto bucket = byCount.find(info.count);
+    bucket->second.erase(info);
+    if (bucket->second.empty())
+        byCount.erase(bucket);
+}
+
+// Remove one entry.
+WaitQueue::iterator WaitQueue::erase(iterator it)
+{
+    byProcess.erase(it->processId);
+    unbucket(*it);
+    return entries.erase(it);
+}
+
+// Reinsert under the new key.
+bool WaitQueue::setPriority(int processId, int priority)
+{
+    auto indexed = byProcess.find(processId);
+    if (indexed == byProcess.end())
+        return false;
+    if (indexed->second->priority == priority)
+        return true;
+    WaitingInfo info = *indexed->second;
+    unbucket(info);
+    info.priority = priority;
+    entries.erase(indexed->second);
+    indexed->second = entries.insert(info).first;
+    byCount[info.count].insert(info);
+    return true;
+}
+
+// Best bucket head past 'after' among the buckets that fit.
+WaitQueue::iterator WaitQueue::nextFitting(int available, const WaitingInfo *after) const
+{
+    ServiceOrder first;
+    const WaitingInfo *best = nullptr;
+    for (auto bucket = byCount.begin(); bucket != byCount.end() && bucket->first <= available; ++bucket)
+    {
+        auto candidate = after ? bucket->second.upper_bound(*after) : bucket->second.begin();
+        if (candidate != bucket->second.end() && (!best || first(*candidate, *best)))
+            best = &*candidate;
+    }
+    return best ? find(best->processId) : entries.end();
+}
+
+// Position of a process's entry (end() if absent).
+WaitQueue::iterator WaitQueue::find(int processId) const
+{
+    auto indexed = byProcess.find(processId);
+    return indexed != byProcess.end() ? iterator(indexed->second) : entries.end();
+}